@@ -0,0 +1,684 @@
+/* Partition.h declares a C++ template that deals the items of an array
+ *  out to the processes of a communicator, and moves them there and back:
+ *  - BLOCK: one contiguous chunk each, the chunk-sizes differing by at
+ *     most 1 (the first numItems % numProcs chunks are the longer ones),
+ *     as getChunkStartStopValues() deals out loop iterations;
+ *  - CYCLIC: item i to process i % numProcs;
+ *  - BLOCK_CYCLIC: blocks of blockSize items, dealt out cyclically;
+ *  - WEIGHTED: one contiguous chunk each, of a length in proportion to
+ *     the process's weight (say, its speed).
+ *
+ * It answers who owns which item, gives each process its items as ranges
+ *  for its loops (forEachOwned(), getRanges()), and the counts and
+ *  displacements for MPI_Scatterv(), MPI_Gatherv() and MPI_Alltoallv().
+ *  It scatters, gathers, and redistributes between two partitions of the
+ *  same items itself, blocking or not (the i-methods return a
+ *  PartitionRequest to wait() on, so the transfer can overlap other
+ *  work). Item counts and indices are 64-bit; transfers too big for the
+ *  int counts of the collectives go as point-to-point messages instead.
+ *
+ * Under CYCLIC and BLOCK_CYCLIC a process's items are not contiguous in
+ *  the array, so the root packs them (or unpacks them, for a gather) in
+ *  process order, and the counts and displacements are of that packed
+ *  order. Under BLOCK and WEIGHTED the packed order is the array's own.
+ *
+ * Usage: Partition<double> part(n, MPI_DOUBLE, MPI_COMM_WORLD, Partition<double>::CYCLIC);
+ *        PartitionRequest pending = part.iscatter(all, mine, 0);
+ *        ... initialize something else ...
+ *        pending.wait();
+ *        part.forEachOwned([&](long long global, long long local) { ... });
+ *        part.gather(mine, all, 0);
+ */
+
+#ifndef PARTITION
+#define PARTITION
+
+#include <mpi.h>                     // C MPI
+#include <vector>                    // C++ vector
+#include <algorithm>                 // upper_bound(), min()
+#include <functional>                // function
+#include <climits>                   // INT_MAX
+#include <utility>                   // move()
+#include <cstdio>                    // fprintf()
+
+#define PARTITION_MAX_MESSAGE (1 << 30)    // items per point-to-point message
+#define PARTITION_TAG         7376
+
+/* terminate all of comm's processes after printing message once
+ * Precondition: the caller is rank of comm
+ *           &&  something has gone wrong that rank cannot recover from.
+ */
+inline void partitionAbort(int rank, const char* message) {
+  fprintf(stderr, "Process %d: Partition: %s\n", rank, message);
+  MPI_Abort(MPI_COMM_WORLD, 1);
+}
+
+/*******************************************************************
+ * A PartitionRequest is a scatter, gather or redistribution begun by
+ *  a Partition's i-methods; wait() (or a test() that returns true)
+ *  finishes it, unpacking what it received if need be.
+ *
+ * It owns the packing buffer of the transfer, and the counts and
+ *  displacements of its collective, so it must live until then (its
+ *  destructor waits); it can be moved, not copied.
+ ******************************************************************/
+
+class PartitionRequest {
+public:
+  PartitionRequest() : myDone(true) { }
+  PartitionRequest(PartitionRequest&& other)
+  : myRequests(std::move(other.myRequests)), myBuffer(std::move(other.myBuffer)),
+    myArguments(std::move(other.myArguments)), myFinish(std::move(other.myFinish)),
+    myDone(other.myDone)
+  { other.myDone = true; }
+  PartitionRequest& operator=(PartitionRequest&& other);
+  PartitionRequest(const PartitionRequest&) = delete;
+  PartitionRequest& operator=(const PartitionRequest&) = delete;
+  ~PartitionRequest()              { wait(); }
+
+  void wait();
+  bool test();
+
+  // for Partition's use
+  std::vector<MPI_Request>& getRequests()      { myDone = false; return myRequests; }
+  std::vector<char>& getBuffer()               { return myBuffer; }
+  std::vector<int>& getArguments()             { return myArguments; }
+  void setFinish(std::function<void()> finish) { myFinish = finish; }
+
+private:
+  std::vector<MPI_Request> myRequests;
+  std::vector<char>        myBuffer;       // items packed in process order
+  std::vector<int>         myArguments;    // the collective's counts and displacements
+  std::function<void()>    myFinish;       // the unpacking, if any
+  bool                     myDone;
+};
+
+/* move assignment: finishes this request's transfer, then takes over other's
+ * Postcondition: other is done, with nothing to wait for.
+ */
+inline PartitionRequest& PartitionRequest::operator=(PartitionRequest&& other) {
+  if (this != &other) {
+    wait();
+    myRequests = std::move(other.myRequests);
+    myBuffer = std::move(other.myBuffer);
+    myArguments = std::move(other.myArguments);
+    myFinish = std::move(other.myFinish);
+    myDone = other.myDone;
+    other.myDone = true;
+  }
+  return *this;
+}
+
+/* method to wait for the transfer to finish
+ * Postcondition: the transfer is complete, and its items are in place.
+ */
+inline void PartitionRequest::wait() {
+  if (!myDone) {
+    MPI_Waitall(myRequests.size(), myRequests.data(), MPI_STATUSES_IGNORE);
+    myDone = true;
+    if (myFinish) {
+      myFinish();
+    }
+    myRequests.clear();
+    myBuffer.clear();
+  }
+}
+
+/* method to check whether the transfer has finished, without waiting
+ * Postcondition: if it has, as after wait().
+ * @return: true iff it has.
+ */
+inline bool PartitionRequest::test() {
+  int finished = 1;
+  if (!myDone) {
+    MPI_Testall(myRequests.size(), myRequests.data(), &finished, MPI_STATUSES_IGNORE);
+    if (finished) {
+      wait();
+    }
+  }
+  return finished != 0;
+}
+
+/*******************************************************************
+ * A Range is the items first..stop-1 of the array.
+ ******************************************************************/
+
+struct Range {
+  long long first;
+  long long stop;
+};
+
+/*******************************************************************
+ * The Partition template deals the numItems items of an array of
+ *  ItemType out to the processes of a communicator.
+ ******************************************************************/
+
+template<class ItemType>
+class Partition {
+public:
+  enum Layout { BLOCK, CYCLIC, BLOCK_CYCLIC, WEIGHTED };
+
+  Partition(long long numItems, MPI_Datatype mpiType, MPI_Comm comm,
+            Layout layout = BLOCK, long long blockSize = 1);
+  Partition(long long numItems, MPI_Datatype mpiType, MPI_Comm comm,
+            const std::vector<double>& weights);
+
+  int getRank() const                  { return myRank; }
+  int getNumProcs() const              { return myNumProcs; }
+  long long getNumItems() const        { return myNumItems; }
+  Layout getLayout() const             { return myLayout; }
+  long long getBlockSize() const       { return myBlockSize; }
+  bool isContiguous() const            { return myLayout == BLOCK || myLayout == WEIGHTED; }
+
+  long long getCount(int rank) const   { return myCounts[rank]; }
+  long long getCount() const           { return myCounts[myRank]; }
+  // where rank's items start in the packed order (the array's, if contiguous)
+  long long getDisplacement(int rank) const { return myDisplacements[rank]; }
+  // this process's items are first..stop-1 of the array, if contiguous
+  long long getStart() const           { return myDisplacements[myRank]; }
+  long long getStop() const            { return myDisplacements[myRank] + myCounts[myRank]; }
+
+  int getOwner(long long global) const;
+  long long toLocal(long long global) const;
+  long long toGlobal(int rank, long long local) const;
+  std::vector<Range> getRanges(int rank) const;
+  std::vector<Range> getRanges() const { return getRanges(myRank); }
+  template<class Function> void forEachOwned(int rank, Function f) const;
+  template<class Function> void forEachOwned(Function f) const { forEachOwned(myRank, f); }
+
+  bool fitsInt() const                 { return myNumItems <= INT_MAX; }
+  std::vector<int> getIntCounts() const;
+  std::vector<int> getIntDisplacements() const;
+  void getAlltoallv(const Partition& to, std::vector<int>& sendCounts,
+                    std::vector<int>& sendDisplacements, std::vector<int>& recvCounts,
+                    std::vector<int>& recvDisplacements) const;
+
+  PartitionRequest iscatter(const ItemType* all, std::vector<ItemType>& mine, int root) const;
+  PartitionRequest igather(const std::vector<ItemType>& mine, ItemType* all, int root) const;
+  PartitionRequest iredistribute(const std::vector<ItemType>& mine, const Partition& to,
+                                 std::vector<ItemType>& theirs) const;
+  void scatter(const ItemType* all, std::vector<ItemType>& mine, int root) const {
+    iscatter(all, mine, root).wait();
+  }
+  void gather(const std::vector<ItemType>& mine, ItemType* all, int root) const {
+    igather(mine, all, root).wait();
+  }
+  void redistribute(const std::vector<ItemType>& mine, const Partition& to,
+                    std::vector<ItemType>& theirs) const {
+    iredistribute(mine, to, theirs).wait();
+  }
+
+private:
+  void setDisplacements();
+  int* setArguments(PartitionRequest& request) const;
+  void pack(const ItemType* all, ItemType* packed) const;
+  void unpack(const ItemType* packed, ItemType* all) const;
+  void postPieces(std::vector<MPI_Request>& requests, bool sending, void* items,
+                  long long count, int peer) const;
+
+  MPI_Comm     myComm;
+  int          myRank;                // MPI process ID
+  int          myNumProcs;            // number of MPI processes
+  MPI_Datatype myMPIType;             // the MPI equiv of ItemType
+  long long    myNumItems;            // in the whole array
+  Layout       myLayout;
+  long long    myBlockSize;           // BLOCK_CYCLIC's (CYCLIC: 1)
+  std::vector<long long> myStarts;    // BLOCK, WEIGHTED: process r has myStarts[r]..myStarts[r+1]-1
+  std::vector<long long> myCounts;    // items of each process
+  std::vector<long long> myDisplacements;  // prefix sums of myCounts
+};
+
+/* Partition constructor, for the BLOCK, CYCLIC and BLOCK_CYCLIC layouts
+ * @param: numItems, a long long
+ * @param: mpiType, an MPI_Datatype value
+ * @param: comm, an MPI_Comm
+ * @param: layout, a Layout
+ * @param: blockSize, a long long
+ * Precondition: numItems >= 0
+ *           &&  mpiType is the MPI equivalent of ItemType
+ *           &&  layout != WEIGHTED (see the other constructor)
+ *           &&  blockSize > 0 (BLOCK_CYCLIC only).
+ * Postcondition: the items have been dealt out to comm's processes
+ *                 as layout says. (No communication happens.)
+ */
+template<class ItemType>
+Partition<ItemType>::Partition(long long numItems, MPI_Datatype mpiType, MPI_Comm comm,
+                               Layout layout, long long blockSize)
+: myComm(comm), myMPIType(mpiType), myNumItems(numItems), myLayout(layout),
+  myBlockSize(layout == BLOCK_CYCLIC ? blockSize : 1)
+{
+  MPI_Comm_rank(comm, &myRank);
+  MPI_Comm_size(comm, &myNumProcs);
+  if (numItems < 0 || myBlockSize < 1 || layout == WEIGHTED) {
+    partitionAbort(myRank, "bad numItems, blockSize or layout");
+  }
+  myCounts.resize(myNumProcs);
+  if (layout == BLOCK) {
+    long long chunkSize = numItems / myNumProcs, remainder = numItems % myNumProcs;
+    myStarts.resize(myNumProcs + 1);
+    for (int r = 0; r <= myNumProcs; ++r) {
+      myStarts[r] = r * chunkSize + std::min<long long>(r, remainder);
+    }
+    for (int r = 0; r < myNumProcs; ++r) {
+      myCounts[r] = myStarts[r + 1] - myStarts[r];
+    }
+  } else {
+    // numBlocks blocks, the last maybe short, block k to process k % numProcs
+    long long numBlocks = (numItems + myBlockSize - 1) / myBlockSize;
+    for (int r = 0; r < myNumProcs; ++r) {
+      myCounts[r] = (numBlocks / myNumProcs + (r < numBlocks % myNumProcs)) * myBlockSize;
+    }
+    if (numBlocks > 0) {
+      myCounts[(numBlocks - 1) % myNumProcs] -= numBlocks * myBlockSize - numItems;
+    }
+  }
+  setDisplacements();
+}
+
+/* Partition constructor, for the WEIGHTED layout
+ * @param: numItems, a long long
+ * @param: mpiType, an MPI_Datatype value
+ * @param: comm, an MPI_Comm
+ * @param: weights, a vector of doubles
+ * Precondition: numItems >= 0
+ *           &&  mpiType is the MPI equivalent of ItemType
+ *           &&  weights holds a weight >= 0 for each of comm's processes,
+ *                not all 0, the same on every process.
+ * Postcondition: process r has a contiguous chunk of about
+ *                 numItems * weights[r] / (the sum of weights) items.
+ */
+template<class ItemType>
+Partition<ItemType>::Partition(long long numItems, MPI_Datatype mpiType, MPI_Comm comm,
+                               const std::vector<double>& weights)
+: myComm(comm), myMPIType(mpiType), myNumItems(numItems), myLayout(WEIGHTED), myBlockSize(1)
+{
+  MPI_Comm_rank(comm, &myRank);
+  MPI_Comm_size(comm, &myNumProcs);
+  long double total = 0, sum = 0;
+  for (int r = 0; r < myNumProcs && r < (int) weights.size(); ++r) {
+    if (weights[r] < 0) {
+      partitionAbort(myRank, "negative weight");
+    }
+    total += weights[r];
+  }
+  if (numItems < 0 || (int) weights.size() != myNumProcs || total <= 0) {
+    partitionAbort(myRank, "bad numItems, or not one weight per process");
+  }
+  myStarts.resize(myNumProcs + 1);
+  myCounts.resize(myNumProcs);
+  myStarts[0] = 0;
+  for (int r = 0; r < myNumProcs; ++r) {
+    // rounding the running sum, so the rounding errors do not add up
+    sum += weights[r];
+    myStarts[r + 1] = r + 1 == myNumProcs ? numItems
+                      : (long long) (numItems * (sum / total) + 0.5L);
+    myCounts[r] = myStarts[r + 1] - myStarts[r];
+  }
+  setDisplacements();
+}
+
+/* utility to compute myDisplacements from myCounts
+ */
+template<class ItemType>
+void Partition<ItemType>::setDisplacements() {
+  myDisplacements.resize(myNumProcs);
+  long long displacement = 0;
+  for (int r = 0; r < myNumProcs; ++r) {
+    myDisplacements[r] = displacement;
+    displacement += myCounts[r];
+  }
+}
+
+/* method to find the owner of an item
+ * @param: global, a long long
+ * Precondition: 0 <= global < getNumItems().
+ * @return: the rank of the process it is dealt to.
+ */
+template<class ItemType>
+int Partition<ItemType>::getOwner(long long global) const {
+  if (isContiguous()) {
+    // the last chunk starting at or before global (empty ones skipped)
+    return std::upper_bound(myStarts.begin(), myStarts.end(), global) - myStarts.begin() - 1;
+  }
+  return (global / myBlockSize) % myNumProcs;
+}
+
+/* method to find an item in its owner's share
+ * @param: global, a long long
+ * Precondition: 0 <= global < getNumItems().
+ * @return: its index among the items of getOwner(global).
+ */
+template<class ItemType>
+long long Partition<ItemType>::toLocal(long long global) const {
+  if (isContiguous()) {
+    return global - myStarts[getOwner(global)];
+  }
+  return (global / myBlockSize) / myNumProcs * myBlockSize + global % myBlockSize;
+}
+
+/* method to find a process's item in the array
+ * @param: rank, an int
+ * @param: local, a long long
+ * Precondition: 0 <= local < getCount(rank).
+ * @return: its index in the whole array.
+ */
+template<class ItemType>
+long long Partition<ItemType>::toGlobal(int rank, long long local) const {
+  if (isContiguous()) {
+    return myStarts[rank] + local;
+  }
+  return ((local / myBlockSize) * myNumProcs + rank) * myBlockSize + local % myBlockSize;
+}
+
+/* method to list a process's items as ranges of the array
+ * @param: rank, an int
+ * @return: its ranges, in order: one for BLOCK and WEIGHTED (none if it has
+ *           no items), one per block for BLOCK_CYCLIC and per item for
+ *           CYCLIC (where forEachOwned() is the cheaper loop).
+ */
+template<class ItemType>
+std::vector<Range> Partition<ItemType>::getRanges(int rank) const {
+  std::vector<Range> ranges;
+  if (isContiguous()) {
+    if (myCounts[rank] > 0) {
+      ranges.push_back(Range{myStarts[rank], myStarts[rank + 1]});
+    }
+  } else {
+    for (long long first = rank * myBlockSize; first < myNumItems;
+         first += myNumProcs * myBlockSize) {
+      ranges.push_back(Range{first, std::min(first + myBlockSize, myNumItems)});
+    }
+  }
+  return ranges;
+}
+
+/* method to loop over a process's items
+ * @param: rank, an int
+ * @param: f, a function (or lambda) of (long long global, long long local)
+ * Postcondition: f has been called for each of rank's items, in order,
+ *                 with its index in the array and in rank's share.
+ */
+template<class ItemType>
+template<class Function>
+void Partition<ItemType>::forEachOwned(int rank, Function f) const {
+  long long local = 0;
+  if (isContiguous()) {
+    for (long long global = myStarts[rank]; global < myStarts[rank + 1]; ++global) {
+      f(global, local++);
+    }
+  } else {
+    for (long long first = rank * myBlockSize; first < myNumItems;
+         first += myNumProcs * myBlockSize) {
+      long long stop = std::min(first + myBlockSize, myNumItems);
+      for (long long global = first; global < stop; ++global) {
+        f(global, local++);
+      }
+    }
+  }
+}
+
+/* methods to get the counts and displacements for MPI_Scatterv()
+ *  and MPI_Gatherv(), in the packed order
+ * Precondition: fitsInt().
+ */
+template<class ItemType>
+std::vector<int> Partition<ItemType>::getIntCounts() const {
+  if (!fitsInt()) {
+    partitionAbort(myRank, "too many items for int counts");
+  }
+  return std::vector<int>(myCounts.begin(), myCounts.end());
+}
+
+template<class ItemType>
+std::vector<int> Partition<ItemType>::getIntDisplacements() const {
+  if (!fitsInt()) {
+    partitionAbort(myRank, "too many items for int displacements");
+  }
+  return std::vector<int>(myDisplacements.begin(), myDisplacements.end());
+}
+
+/* method to get the counts and displacements for the MPI_Alltoallv()
+ *  that moves the items from this partition to another
+ * @param: to, a Partition of the same items over the same processes
+ * @param: sendCounts, sendDisplacements, recvCounts, recvDisplacements,
+ *          vectors of ints
+ * Precondition: fitsInt().
+ * Postcondition: sendCounts[r] is how many of this process's items r
+ *                 has in to, at sendDisplacements[r] of a send buffer
+ *                 holding them in order of r, then of the array;
+ *             && recvCounts[r] and recvDisplacements[r] are the same
+ *                 for the items coming from r.
+ */
+template<class ItemType>
+void Partition<ItemType>::getAlltoallv(const Partition& to, std::vector<int>& sendCounts,
+                                       std::vector<int>& sendDisplacements,
+                                       std::vector<int>& recvCounts,
+                                       std::vector<int>& recvDisplacements) const {
+  if (!fitsInt() || to.getNumItems() != myNumItems || to.getNumProcs() != myNumProcs) {
+    partitionAbort(myRank, "redistribution between partitions of different arrays");
+  }
+  sendCounts.assign(myNumProcs, 0);
+  recvCounts.assign(myNumProcs, 0);
+  forEachOwned([&](long long global, long long) { ++sendCounts[to.getOwner(global)]; });
+  to.forEachOwned([&](long long global, long long) { ++recvCounts[getOwner(global)]; });
+  sendDisplacements.assign(myNumProcs, 0);
+  recvDisplacements.assign(myNumProcs, 0);
+  for (int r = 1; r < myNumProcs; ++r) {
+    sendDisplacements[r] = sendDisplacements[r - 1] + sendCounts[r - 1];
+    recvDisplacements[r] = recvDisplacements[r - 1] + recvCounts[r - 1];
+  }
+}
+
+/* utility to keep the int counts and then the displacements in request
+ * Precondition: fitsInt().
+ * @return: the address of the counts; the displacements follow them.
+ */
+template<class ItemType>
+int* Partition<ItemType>::setArguments(PartitionRequest& request) const {
+  std::vector<int>& arguments = request.getArguments();
+  arguments = getIntCounts();
+  std::vector<int> displacements = getIntDisplacements();
+  arguments.insert(arguments.end(), displacements.begin(), displacements.end());
+  return arguments.data();
+}
+
+/* utility to copy the array's items into process order, and back
+ */
+template<class ItemType>
+void Partition<ItemType>::pack(const ItemType* all, ItemType* packed) const {
+  for (int r = 0; r < myNumProcs; ++r) {
+    ItemType* next = packed + myDisplacements[r];
+    forEachOwned(r, [&](long long global, long long local) { next[local] = all[global]; });
+  }
+}
+
+template<class ItemType>
+void Partition<ItemType>::unpack(const ItemType* packed, ItemType* all) const {
+  for (int r = 0; r < myNumProcs; ++r) {
+    const ItemType* next = packed + myDisplacements[r];
+    forEachOwned(r, [&](long long global, long long local) { all[global] = next[local]; });
+  }
+}
+
+/* utility to send (or receive) count items as messages of at most
+ *  PARTITION_MAX_MESSAGE items, for transfers too big for int counts
+ * Postcondition: their requests have been appended to requests.
+ */
+template<class ItemType>
+void Partition<ItemType>::postPieces(std::vector<MPI_Request>& requests, bool sending,
+                                     void* items, long long count, int peer) const {
+  ItemType* next = static_cast<ItemType*>(items);
+  for (long long done = 0; done < count; done += PARTITION_MAX_MESSAGE) {
+    int piece = (int) std::min<long long>(count - done, PARTITION_MAX_MESSAGE);
+    requests.push_back(MPI_REQUEST_NULL);
+    if (sending) {
+      MPI_Isend(next + done, piece, myMPIType, peer, PARTITION_TAG, myComm, &requests.back());
+    } else {
+      MPI_Irecv(next + done, piece, myMPIType, peer, PARTITION_TAG, myComm, &requests.back());
+    }
+  }
+}
+
+/* method to begin scattering an array to its owners
+ * @param: all, the address of the array (root only; others may pass NULL)
+ * @param: mine, a vector
+ * @param: root, an int
+ * Precondition: every process of the communicator calls this, with the same root.
+ * Postcondition: mine has been sized to getCount(), and once the returned
+ *                 request is waited on holds this process's items, in order.
+ * @return: the request.
+ */
+template<class ItemType>
+PartitionRequest Partition<ItemType>::iscatter(const ItemType* all, std::vector<ItemType>& mine,
+                                               int root) const {
+  PartitionRequest request;
+  std::vector<MPI_Request>& requests = request.getRequests();
+  const ItemType* packed = all;
+
+  mine.resize(myCounts[myRank]);
+  if (myRank == root && !isContiguous()) {
+    request.getBuffer().resize(myNumItems * sizeof(ItemType));
+    pack(all, reinterpret_cast<ItemType*>(request.getBuffer().data()));
+    packed = reinterpret_cast<const ItemType*>(request.getBuffer().data());
+  }
+  if (fitsInt()) {
+    int* counts = setArguments(request);
+    requests.push_back(MPI_REQUEST_NULL);
+    MPI_Iscatterv(packed, counts, counts + myNumProcs, myMPIType, mine.data(),
+                  counts[myRank], myMPIType, root, myComm, &requests.back());
+  } else {
+    if (myRank == root) {
+      for (int r = 0; r < myNumProcs; ++r) {
+        if (r != root) {
+          postPieces(requests, true, const_cast<ItemType*>(packed) + myDisplacements[r],
+                     myCounts[r], r);
+        }
+      }
+      std::copy(packed + myDisplacements[root], packed + myDisplacements[root] + myCounts[root],
+                mine.begin());
+    } else {
+      postPieces(requests, false, mine.data(), myCounts[myRank], root);
+    }
+  }
+  return request;
+}
+
+/* method to begin gathering the processes' items into an array
+ * @param: mine, a vector of this process's getCount() items, in order
+ * @param: all, the address of room for getNumItems() items (root only)
+ * @param: root, an int
+ * Precondition: every process of the communicator calls this, with the same root
+ *           &&  mine is left alone, and this Partition kept, until the
+ *                returned request is waited on.
+ * Postcondition: once the request is waited on, all holds the whole array (root).
+ * @return: the request.
+ */
+template<class ItemType>
+PartitionRequest Partition<ItemType>::igather(const std::vector<ItemType>& mine, ItemType* all,
+                                              int root) const {
+  PartitionRequest request;
+  std::vector<MPI_Request>& requests = request.getRequests();
+  ItemType* packed = all;
+
+  if (myRank == root && !isContiguous()) {
+    request.getBuffer().resize(myNumItems * sizeof(ItemType));
+    packed = reinterpret_cast<ItemType*>(request.getBuffer().data());
+    // the buffer's memory stays put when the request is moved
+    request.setFinish([this, packed, all]() { unpack(packed, all); });
+  }
+  if (fitsInt()) {
+    int* counts = setArguments(request);
+    requests.push_back(MPI_REQUEST_NULL);
+    MPI_Igatherv(mine.data(), counts[myRank], myMPIType, packed, counts,
+                 counts + myNumProcs, myMPIType, root, myComm, &requests.back());
+  } else {
+    if (myRank == root) {
+      for (int r = 0; r < myNumProcs; ++r) {
+        if (r != root) {
+          postPieces(requests, false, packed + myDisplacements[r], myCounts[r], r);
+        }
+      }
+      std::copy(mine.begin(), mine.end(), packed + myDisplacements[root]);
+    } else {
+      postPieces(requests, true, const_cast<ItemType*>(mine.data()), myCounts[myRank], root);
+    }
+  }
+  return request;
+}
+
+/* method to begin moving the items from this partition to another
+ * @param: mine, a vector of this process's getCount() items, in order
+ * @param: to, a Partition of the same items over the same processes
+ * @param: theirs, a vector
+ * Precondition: every process of the communicator calls this
+ *           &&  this Partition (and to) outlive the returned request.
+ * Postcondition: theirs has been sized to to.getCount(), and once the
+ *                 request is waited on holds this process's items under to.
+ * @return: the request.
+ */
+template<class ItemType>
+PartitionRequest Partition<ItemType>::iredistribute(const std::vector<ItemType>& mine,
+                                                    const Partition& to,
+                                                    std::vector<ItemType>& theirs) const {
+  PartitionRequest request;
+  std::vector<MPI_Request>& requests = request.getRequests();
+  std::vector<long long> sendCounts(myNumProcs, 0), recvCounts(myNumProcs, 0);
+
+  if (to.getNumItems() != myNumItems || to.getNumProcs() != myNumProcs) {
+    partitionAbort(myRank, "redistribution between partitions of different arrays");
+  }
+  forEachOwned([&](long long global, long long) { ++sendCounts[to.getOwner(global)]; });
+  to.forEachOwned([&](long long global, long long) { ++recvCounts[getOwner(global)]; });
+  theirs.resize(to.getCount());
+
+  // one buffer: what goes out, by destination, then what comes in, by source
+  std::vector<long long> sendAt(myNumProcs + 1, 0), recvAt(myNumProcs + 1, 0);
+  for (int r = 0; r < myNumProcs; ++r) {
+    sendAt[r + 1] = sendAt[r] + sendCounts[r];
+    recvAt[r + 1] = recvAt[r] + recvCounts[r];
+  }
+  request.getBuffer().resize((sendAt[myNumProcs] + recvAt[myNumProcs]) * sizeof(ItemType));
+  ItemType* outgoing = reinterpret_cast<ItemType*>(request.getBuffer().data());
+  ItemType* incoming = outgoing + sendAt[myNumProcs];
+  std::vector<long long> next(sendAt.begin(), sendAt.end() - 1);
+  forEachOwned([&](long long global, long long local) {
+    outgoing[next[to.getOwner(global)]++] = mine[local];
+  });
+
+  // each source sends its items in its order, which is the array's, so is to's
+  ItemType* result = theirs.data();
+  const Partition* from = this;
+  const Partition* into = &to;
+  request.setFinish([from, into, incoming, result, recvAt]() {
+    std::vector<long long> next(recvAt.begin(), recvAt.end() - 1);
+    into->forEachOwned([&](long long global, long long local) {
+      result[local] = incoming[next[from->getOwner(global)]++];
+    });
+  });
+
+  if (fitsInt()) {
+    // send counts, send displacements, receive counts, receive displacements
+    std::vector<int>& arguments = request.getArguments();
+    arguments.resize(4 * myNumProcs);
+    for (int r = 0; r < myNumProcs; ++r) {
+      arguments[r] = sendCounts[r];
+      arguments[myNumProcs + r] = sendAt[r];
+      arguments[2 * myNumProcs + r] = recvCounts[r];
+      arguments[3 * myNumProcs + r] = recvAt[r];
+    }
+    int* a = arguments.data();
+    requests.push_back(MPI_REQUEST_NULL);
+    MPI_Ialltoallv(outgoing, a, a + myNumProcs, myMPIType, incoming, a + 2 * myNumProcs,
+                   a + 3 * myNumProcs, myMPIType, myComm, &requests.back());
+  } else {
+    for (int r = 0; r < myNumProcs; ++r) {
+      postPieces(requests, false, incoming + recvAt[r], recvCounts[r], r);
+    }
+    for (int r = 0; r < myNumProcs; ++r) {
+      postPieces(requests, true, outgoing + sendAt[r], sendCounts[r], r);
+    }
+  }
+  return request;
+}
+
+#endif
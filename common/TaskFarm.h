@@ -0,0 +1,470 @@
+/* TaskFarm.h declares a C++ template that farms independent tasks out
+ *  to the processes of a communicator, master-worker style: process 0
+ *  holds the tasks and collects the results, and the other processes
+ *  compute them, as fast as each can.
+ *
+ * A task and its result are plain structs (trivially copyable, sent as
+ *  bytes), and the work is a function from one to the other. The master
+ *  keeps prefetch tasks in flight to each worker, so a worker that
+ *  finishes one finds the next already there instead of waiting a round
+ *  trip for it; each result it sends back earns it one more task.
+ *  Tasks go out by MPI_Isend(), each bundle kept until its send is done,
+ *  so a master never waits on a worker busy with the tasks before.
+ *  Results stream in through a few MPI_Irecv()s on MPI_ANY_SOURCE, and
+ *  are put back in task order.
+ *
+ * With hundreds of workers one master answering every result becomes the
+ *  bottleneck, so with a groupSize the workers are split into groups of
+ *  about that many processes, the first of each a sub-master: the master
+ *  sends a sub-master bundles of tasks (one per worker of its group) and
+ *  receives bundles of results, and the sub-master farms them out in its
+ *  group as the master would. The master then answers one message per
+ *  bundle instead of one per task.
+ *
+ * When the tasks run out, every master sends each of its workers (and
+ *  sub-masters) an empty bundle, which comes after all their tasks; a
+ *  sub-master passes it on once its own tasks are done, and returns
+ *  when their results are in. Every process times itself (the tasks it
+ *  did, the seconds it spent on them, and the seconds it ran), and
+ *  process 0 gathers these for report().
+ *
+ * Usage: TaskFarm<Tile, TileResult> farm(MPI_COMM_WORLD, 2);
+ *        std::vector<Tile> tiles;          // process 0's
+ *        std::vector<TileResult> results;  // process 0's, in tiles' order
+ *        farm.run(tiles, results, [](const Tile& t) { ... return r; });
+ *        farm.report("tiles");
+ */
+
+#ifndef TASK_FARM
+#define TASK_FARM
+
+#include <mpi.h>                     // C MPI
+#include <vector>                    // C++ vector
+#include <deque>                     // deque
+#include <functional>                // function
+#include <algorithm>                 // min(), max()
+#include <type_traits>               // is_trivially_copyable
+#include <utility>                   // move()
+#include <cstdio>                    // printf()
+
+#define TASK_FARM_TAG_TASKS   7377
+#define TASK_FARM_TAG_RESULTS 7378
+#define TASK_FARM_RECEIVES    8      // results receives posted at once, at most
+
+/*******************************************************************
+ * TaskFarmStats are one process's share of a run.
+ ******************************************************************/
+
+struct TaskFarmStats {
+  enum Role { MASTER, SUB_MASTER, WORKER };
+
+  double tasks;          // computed (a worker) or handed out (a master)
+  double busySeconds;    // computing them (a worker) or not waiting (a master)
+  double seconds;        // from the start of the run to this process's end
+  int    role;
+};
+
+/*******************************************************************
+ * The TaskFarm template runs the Tasks of process 0 on the other
+ *  processes of a communicator, giving process 0 back their Results.
+ ******************************************************************/
+
+template<class Task, class Result>
+class TaskFarm {
+  static_assert(std::is_trivially_copyable<Task>::value, "a Task is sent as bytes");
+  static_assert(std::is_trivially_copyable<Result>::value, "a Result is sent as bytes");
+
+public:
+  TaskFarm(MPI_Comm comm, int prefetch = 2, int groupSize = 0);
+  TaskFarm(const TaskFarm&) = delete;
+  TaskFarm& operator=(const TaskFarm&) = delete;
+  ~TaskFarm();
+
+  void run(const std::vector<Task>& tasks, std::vector<Result>& results,
+           std::function<Result(const Task&)> work);
+  void report(const char* label, bool everyProcess = false) const;
+
+  int getRole() const                            { return myRole; }
+  const std::vector<TaskFarmStats>& getStats() const { return myStats; }
+
+private:
+  struct TaskEntry   { long long index; Task task; };
+  struct ResultEntry { long long index; Result result; };
+  struct SentBundle  { MPI_Request request; std::vector<TaskEntry> tasks; };
+
+  void compute(std::function<Result(const Task&)>& work);
+  void serve(const std::vector<Task>* tasks, std::vector<Result>* results);
+  int  receive(std::vector<MPI_Request>& requests, MPI_Status* status);
+  void retire(std::vector<std::deque<SentBundle> >& sending, bool wait);
+  void flush(std::vector<ResultEntry>& done);
+
+  MPI_Comm          myComm;          // a duplicate, so our tags are our own
+  int               myRank;
+  int               mySize;
+  int               myPrefetch;
+  int               myRole;
+  int               myParent;        // who sends this process its tasks
+  std::vector<int>  myChildren;      // to whom this process sends tasks
+  std::vector<int>  myBundles;       // the tasks per message to each child
+  int               myBundle;        // the tasks per message from the parent
+  double            myStart;
+  TaskFarmStats     myOwn;
+  std::vector<TaskFarmStats> myStats;    // every process's, on process 0
+};
+
+/* explicit constructor
+ * @param: comm, the processes of the farm; process 0 is its master.
+ * @param: prefetch, the tasks (or bundles) to keep in flight to each
+ *          worker (sub-master).
+ * @param: groupSize, the processes per group under a sub-master;
+ *          0 (or too few processes to fill two groups) for none.
+ * Precondition: every process of comm calls this, with the same arguments.
+ * Postcondition: the farm's layout is set: who is master, sub-master or
+ *                 worker, and who sends whom tasks.
+ */
+template<class Task, class Result>
+TaskFarm<Task, Result>::TaskFarm(MPI_Comm comm, int prefetch, int groupSize)
+: myPrefetch(std::max(prefetch, 1)), myParent(MPI_PROC_NULL), myBundle(1)
+{
+  MPI_Comm_dup(comm, &myComm);
+  MPI_Comm_rank(myComm, &myRank);
+  MPI_Comm_size(myComm, &mySize);
+  myRole = myRank == 0 ? TaskFarmStats::MASTER : TaskFarmStats::WORKER;
+
+  int numWorkers = mySize - 1;
+  if (groupSize < 2 || numWorkers < 2 * groupSize) {
+    // flat: process 0 serves everyone
+    for (int r = 1; r < mySize; r++) {
+      if (myRank == 0) {
+        myChildren.push_back(r);
+        myBundles.push_back(1);
+      }
+    }
+    if (myRank != 0) {
+      myParent = 0;
+    }
+    return;
+  }
+
+  // groups of processes 1.., the last one longer rather than too short
+  int numGroups = numWorkers / groupSize;
+  for (int g = 0; g < numGroups; g++) {
+    int first = 1 + g * groupSize;
+    int stop = g == numGroups - 1 ? mySize : first + groupSize;
+    if (myRank == 0) {
+      myChildren.push_back(first);
+      myBundles.push_back(stop - first - 1);
+    } else if (myRank == first) {
+      myRole = TaskFarmStats::SUB_MASTER;
+      myParent = 0;
+      myBundle = stop - first - 1;
+      for (int r = first + 1; r < stop; r++) {
+        myChildren.push_back(r);
+        myBundles.push_back(1);
+      }
+    } else if (myRank > first && myRank < stop) {
+      myParent = first;
+    }
+  }
+}
+
+/* destructor: frees the farm's communicator, unless MPI_Finalize()
+ *  (called before a farm of main() goes out of scope) already has
+ */
+template<class Task, class Result>
+TaskFarm<Task, Result>::~TaskFarm() {
+  int finalized;
+  MPI_Finalized(&finalized);
+  if (!finalized) {
+    MPI_Comm_free(&myComm);
+  }
+}
+
+/* method to run a farm's tasks
+ * @param: tasks, the tasks (process 0's; the others' are ignored).
+ * @param: results, for their results (process 0's).
+ * @param: work, the function that computes a task's result.
+ * Precondition: every process of the farm calls this.
+ * Postcondition: on process 0, results[i] == work(tasks[i]) for every i,
+ *                 and getStats() holds every process's share.
+ */
+template<class Task, class Result>
+void TaskFarm<Task, Result>::run(const std::vector<Task>& tasks, std::vector<Result>& results,
+                                 std::function<Result(const Task&)> work)
+{
+  myOwn = TaskFarmStats{0.0, 0.0, 0.0, myRole};
+  myStart = MPI_Wtime();
+
+  if (mySize == 1) {
+    // no one to farm out to
+    results.resize(tasks.size());
+    for (size_t i = 0; i < tasks.size(); i++) {
+      results[i] = work(tasks[i]);
+    }
+    myOwn.tasks = tasks.size();
+    myOwn.busySeconds = MPI_Wtime() - myStart;
+  } else if (myRole == TaskFarmStats::MASTER) {
+    results.resize(tasks.size());
+    serve(&tasks, &results);
+  } else if (myRole == TaskFarmStats::SUB_MASTER) {
+    serve(NULL, NULL);
+  } else {
+    compute(work);
+  }
+  myOwn.seconds = MPI_Wtime() - myStart;
+
+  myStats.resize(myRank == 0 ? mySize : 0);
+  MPI_Gather(&myOwn, sizeof(TaskFarmStats), MPI_BYTE,
+             myStats.data(), sizeof(TaskFarmStats), MPI_BYTE, 0, myComm);
+}
+
+/* a worker's part of run(): compute tasks until the empty bundle comes
+ */
+template<class Task, class Result>
+void TaskFarm<Task, Result>::compute(std::function<Result(const Task&)>& work) {
+  std::vector<TaskEntry> arriving(myBundle), current(myBundle);
+  MPI_Request request;
+  MPI_Status status;
+  int bytes;
+
+  // the next bundle lands while this one is computed
+  MPI_Irecv(arriving.data(), arriving.size() * sizeof(TaskEntry), MPI_BYTE, myParent,
+            TASK_FARM_TAG_TASKS, myComm, &request);
+  while (true) {
+    MPI_Wait(&request, &status);
+    MPI_Get_count(&status, MPI_BYTE, &bytes);
+    int count = bytes / sizeof(TaskEntry);
+    if (count == 0) {
+      break;
+    }
+    current.swap(arriving);
+    MPI_Irecv(arriving.data(), arriving.size() * sizeof(TaskEntry), MPI_BYTE, myParent,
+              TASK_FARM_TAG_TASKS, myComm, &request);
+
+    for (int i = 0; i < count; i++) {
+      double start = MPI_Wtime();
+      ResultEntry done = {current[i].index, work(current[i].task)};
+      myOwn.busySeconds += MPI_Wtime() - start;
+      myOwn.tasks++;
+      MPI_Send(&done, sizeof(ResultEntry), MPI_BYTE, myParent, TASK_FARM_TAG_RESULTS, myComm);
+    }
+  }
+}
+
+/* wait for one of a (sub-)master's receives, timing the wait as idle
+ * @return: the index of the request that finished.
+ */
+template<class Task, class Result>
+int TaskFarm<Task, Result>::receive(std::vector<MPI_Request>& requests, MPI_Status* status) {
+  int index;
+  double start = MPI_Wtime();
+  MPI_Waitany(requests.size(), requests.data(), &index, status);
+  myOwn.busySeconds -= MPI_Wtime() - start;
+  return index;
+}
+
+/* complete the bundle sends to each child, oldest first, freeing their
+ *  buffers
+ * @param: wait, whether to wait for them all, or only drop those done.
+ */
+template<class Task, class Result>
+void TaskFarm<Task, Result>::retire(std::vector<std::deque<SentBundle> >& sending, bool wait) {
+  for (size_t c = 0; c < sending.size(); c++) {
+    while (!sending[c].empty()) {
+      int finished = 1;
+      if (wait) {
+        MPI_Wait(&sending[c].front().request, MPI_STATUS_IGNORE);
+      } else {
+        MPI_Test(&sending[c].front().request, &finished, MPI_STATUS_IGNORE);
+      }
+      if (!finished) {
+        break;
+      }
+      sending[c].pop_front();
+    }
+  }
+}
+
+/* send a sub-master's finished results up, as one bundle
+ */
+template<class Task, class Result>
+void TaskFarm<Task, Result>::flush(std::vector<ResultEntry>& done) {
+  MPI_Send(done.data(), done.size() * sizeof(ResultEntry), MPI_BYTE, myParent,
+           TASK_FARM_TAG_RESULTS, myComm);
+  done.clear();
+}
+
+/* a master's or sub-master's part of run(): keep every child prefetch
+ *  bundles ahead until the tasks run out, then stop them, and collect
+ *  their results (into results, or up to the parent).
+ * @param: tasks, the master's tasks; NULL for a sub-master, whose come
+ *          from its parent.
+ */
+template<class Task, class Result>
+void TaskFarm<Task, Result>::serve(const std::vector<Task>* tasks, std::vector<Result>* results) {
+  const int numChildren = myChildren.size();
+  const int mostPerMessage = *std::max_element(myBundles.begin(), myBundles.end());
+  const int numReceives = std::min(numChildren, TASK_FARM_RECEIVES);
+  std::deque<TaskEntry> queue;
+  std::vector<long long> outstanding(numChildren, 0);     // tasks sent, not yet back
+  std::vector<bool> stopped(numChildren, false);
+  std::vector<std::deque<SentBundle> > sending(numChildren);  // bundles in flight to each child
+  std::vector<ResultEntry> done;
+  std::vector<int> childOf(mySize, -1);
+  long long next = 0, received = 0, expected = tasks ? (long long) tasks->size() : 0;
+  bool upstreamDone = tasks != NULL;
+
+  for (int c = 0; c < numChildren; c++) {
+    childOf[myChildren[c]] = c;
+  }
+
+  // requests[0] is the next bundle from the parent, requests[1..] results
+  std::vector<MPI_Request> requests(1 + numReceives, MPI_REQUEST_NULL);
+  std::vector<std::vector<ResultEntry> > landing(numReceives,
+                                                 std::vector<ResultEntry>(mostPerMessage));
+  std::vector<TaskEntry> fromParent(myBundle);
+  if (!upstreamDone) {
+    MPI_Irecv(fromParent.data(), fromParent.size() * sizeof(TaskEntry), MPI_BYTE, myParent,
+              TASK_FARM_TAG_TASKS, myComm, &requests[0]);
+  }
+  for (int k = 0; k < numReceives; k++) {
+    MPI_Irecv(landing[k].data(), landing[k].size() * sizeof(ResultEntry), MPI_BYTE,
+              MPI_ANY_SOURCE, TASK_FARM_TAG_RESULTS, myComm, &requests[1 + k]);
+  }
+
+  while (true) {
+    // top every child up to prefetch bundles; stop them once no more will come
+    for (int c = 0; c < numChildren; c++) {
+      while (!stopped[c] && outstanding[c] <= (long long) (myPrefetch - 1) * myBundles[c]) {
+        SentBundle sent = {MPI_REQUEST_NULL, std::vector<TaskEntry>()};
+        std::vector<TaskEntry>& bundle = sent.tasks;
+        while ((int) bundle.size() < myBundles[c]) {
+          if (tasks && next < expected) {
+            TaskEntry entry = {next, (*tasks)[next]};
+            bundle.push_back(entry);
+            next++;
+          } else if (!queue.empty()) {
+            bundle.push_back(queue.front());
+            queue.pop_front();
+          } else {
+            break;
+          }
+        }
+        if (bundle.empty() && !upstreamDone) {
+          break;                // more may come from the parent
+        }
+        if (bundle.empty()) {
+          stopped[c] = true;
+        }
+        outstanding[c] += bundle.size();
+        myOwn.tasks += bundle.size();
+        // the deque moves the bundle, not its tasks, so the send's buffer stays put
+        sending[c].push_back(std::move(sent));
+        SentBundle& last = sending[c].back();
+        MPI_Isend(last.tasks.data(), last.tasks.size() * sizeof(TaskEntry), MPI_BYTE,
+                  myChildren[c], TASK_FARM_TAG_TASKS, myComm, &last.request);
+      }
+    }
+
+    // a sub-master asks for more (by sending what it has) when a worker is idle
+    bool idle = false;
+    long long inFlight = 0;
+    for (int c = 0; c < numChildren; c++) {
+      idle = idle || (!stopped[c] && outstanding[c] == 0);
+      inFlight += outstanding[c];
+    }
+    if (!tasks && !done.empty() && (idle || (int) done.size() >= myBundle ||
+                                    (upstreamDone && inFlight == 0))) {
+      flush(done);
+    }
+    if (tasks ? received == expected : upstreamDone && inFlight == 0 && queue.empty()) {
+      break;
+    }
+
+    MPI_Status status;
+    int index = receive(requests, &status);
+    retire(sending, false);
+    int bytes;
+    MPI_Get_count(&status, MPI_BYTE, &bytes);
+    if (index == 0) {
+      int count = bytes / sizeof(TaskEntry);
+      queue.insert(queue.end(), fromParent.begin(), fromParent.begin() + count);
+      if (count == 0) {
+        upstreamDone = true;
+      } else {
+        MPI_Irecv(fromParent.data(), fromParent.size() * sizeof(TaskEntry), MPI_BYTE, myParent,
+                  TASK_FARM_TAG_TASKS, myComm, &requests[0]);
+      }
+    } else {
+      std::vector<ResultEntry>& in = landing[index - 1];
+      int count = bytes / sizeof(ResultEntry);
+      for (int i = 0; i < count; i++) {
+        if (results) {
+          (*results)[in[i].index] = in[i].result;
+        } else {
+          done.push_back(in[i]);
+        }
+      }
+      received += count;
+      outstanding[childOf[status.MPI_SOURCE]] -= count;
+      MPI_Irecv(in.data(), in.size() * sizeof(ResultEntry), MPI_BYTE, MPI_ANY_SOURCE,
+                TASK_FARM_TAG_RESULTS, myComm, &requests[index]);
+    }
+  }
+
+  for (int k = 1; k <= numReceives; k++) {
+    MPI_Cancel(&requests[k]);
+    MPI_Request_free(&requests[k]);
+  }
+  retire(sending, true);
+  myOwn.busySeconds += MPI_Wtime() - myStart;
+}
+
+/* method to print how the last run went, on process 0
+ * @param: label, what the tasks were.
+ * @param: everyProcess, whether to print each process's line too.
+ * Precondition: run() has been called.
+ */
+template<class Task, class Result>
+void TaskFarm<Task, Result>::report(const char* label, bool everyProcess) const {
+  if (myRank != 0) {
+    return;
+  }
+  const char* roles[] = {"master", "sub-master", "worker"};
+  double seconds = myStats[0].seconds, fewest = 1e300, most = 0.0, total = 0.0;
+  double leastBusy = 1.0, mostBusy = 0.0, busy = 0.0;
+  int numWorkers = 0, numSubMasters = 0;
+
+  for (int r = 0; r < mySize; r++) {
+    const TaskFarmStats& s = myStats[r];
+    double share = s.seconds > 0.0 ? s.busySeconds / s.seconds : 0.0;
+    if (s.role == TaskFarmStats::SUB_MASTER) {
+      numSubMasters++;
+    } else if (s.role == TaskFarmStats::WORKER || mySize == 1) {
+      numWorkers++;
+      total += s.tasks;
+      fewest = std::min(fewest, s.tasks);
+      most = std::max(most, s.tasks);
+      busy += share;
+      leastBusy = std::min(leastBusy, share);
+      mostBusy = std::max(mostBusy, share);
+    }
+    if (everyProcess && s.role == TaskFarmStats::WORKER) {
+      printf("  process %4d %-10s %10.0f tasks %10.1f tasks/s, busy %5.1f%% of %f s\n", r,
+             roles[s.role], s.tasks, s.busySeconds > 0.0 ? s.tasks / s.busySeconds : 0.0,
+             100.0 * share, s.seconds);
+    } else if (everyProcess) {
+      printf("  process %4d %-10s %10.0f tasks handed out, busy %5.1f%% of %f s\n", r,
+             roles[s.role], s.tasks, 100.0 * share, s.seconds);
+    }
+  }
+  printf("%s: %.0f tasks on %d workers (%d sub-masters, prefetch %d) in %f s, %.1f tasks/s\n",
+         label, total, numWorkers, numSubMasters, myPrefetch, seconds,
+         seconds > 0.0 ? total / seconds : 0.0);
+  printf("  tasks per worker %.0f to %.0f (mean %.1f); workers busy %.1f%% to %.1f%% "
+         "(mean %.1f%%); master busy %.1f%%\n", fewest, most, total / numWorkers,
+         100.0 * leastBusy, 100.0 * mostBusy, 100.0 * busy / numWorkers,
+         seconds > 0.0 ? 100.0 * myStats[0].busySeconds / seconds : 0.0);
+}
+
+#endif
@@ -0,0 +1,406 @@
+/* asyncReduction.h reduces partial results in the background while a
+ *  program keeps computing, instead of stopping for an MPI_Reduce().
+ *
+ * Several small arrays (say a program's 101 sums of doubles, 101 counts
+ *  of longs and 1 count of trials) are fused into one reduction: each is
+ *  a field of one derived datatype (MPI_Type_create_struct()), reduced by
+ *  one user op that applies each field's own op (MPI_SUM, MPI_MAX,
+ *  MPI_MIN or MPI_LOR) to it. So the fields cost one latency, not one
+ *  each, and the start is one MPI_Ireduce() (MPI_Iallreduce()).
+ *
+ * startAsyncReduction() packs the fields (so the caller may change them
+ *  at once) and posts the reduction; progressAsyncReduction(), called
+ *  every so often from the compute loop, MPI_Test()s it, which is what
+ *  moves it along in most MPI libraries; finishAsyncReduction() waits for
+ *  what is left. With hierarchical set, it reduces within each node
+ *  first and then among the nodes' first processes (topology.h), posting
+ *  each stage when the one before is done, so one process per node uses
+ *  the network (for root 0 or ASYNC_ALL; other roots reduce flat).
+ *
+ * Each reduction is timed: from when its first stage is posted to when it
+ *  is seen finished (in flight), the part of that spent blocked in
+ *  finishAsyncReduction() (waited), and the time the MPI_Test()s took.
+ *  In flight minus waited is the communication hidden behind computing;
+ *  reportAsyncReduction() prints the slowest process's totals, and the
+ *  least and most any process hid.
+ *
+ * Usage: #include "../common/asyncReduction.h"    (C or C++)
+ *        asyncReduction sums;
+ *        initAsyncReduction(&sums, 1);
+ *        addReductionField(&sums, partial, total, n, MPI_DOUBLE, MPI_SUM);
+ *        startAsyncReduction(&sums, 0, MPI_COMM_WORLD);
+ *        for (...) { ... compute ...; progressAsyncReduction(&sums); }
+ *        finishAsyncReduction(&sums);     ... total holds the sums on process 0
+ *        reportAsyncReduction(&sums, "partial sums", stdout);
+ *        freeAsyncReduction(&sums);
+ */
+
+#ifndef ASYNC_REDUCTION
+#define ASYNC_REDUCTION
+
+#include <stdio.h>     // fprintf()
+#include <stdlib.h>    // malloc()
+#include <string.h>    // memcpy()
+#include <mpi.h>       // MPI functions
+#include "topology.h"  // getTopology()
+
+#define ASYNC_MAX_FIELDS 8
+#define ASYNC_ALL        (-1)    // the root for an allreduce: every process gets the result
+
+typedef struct {
+    const void *data;       // the caller's array
+    void *result;           // where its reduction goes
+    int count;
+    MPI_Datatype type;      // MPI_INT, MPI_LONG, MPI_LONG_LONG or MPI_DOUBLE
+    MPI_Op op;              // MPI_SUM, MPI_MAX, MPI_MIN or MPI_LOR
+    MPI_Aint offset;        // in the packed buffers
+} reductionField;
+
+typedef struct {
+    int numFields;
+    reductionField fields[ASYNC_MAX_FIELDS];
+    MPI_Aint bytes;         // of the packed fields
+    char *send, *receive;   // the packed fields, and their reduction
+    MPI_Datatype fused;     // all the fields, as one element
+    MPI_Op op;
+    int hierarchical;
+    MPI_Comm node, leaders; // hierarchical: its own copies of topology.h's, so
+                            //  its stages never cross other collectives on those
+    int root;
+    MPI_Comm comm;
+    int stage;              // 0: none in flight; 1: within comm or the node;
+                            //  2: among the nodes; 3: back within the node
+    MPI_Request request;
+
+    long reductions, tests;
+    double postedAt;        // MPI_Wtime() once the last start was posted
+    double inFlight, waited, testing;    // totals, in seconds
+} asyncReduction;
+
+static int asyncReductionKey = MPI_KEYVAL_INVALID;
+
+#define ASYNC_COMBINE(T)                                                      \
+    {                                                                         \
+        const T *a = (const T *) in;                                          \
+        T *b = (T *) inout;                                                   \
+        int i;                                                                \
+        if (op == MPI_SUM) {                                                  \
+            for (i = 0; i < count; i++) b[i] += a[i];                         \
+        } else if (op == MPI_MAX) {                                           \
+            for (i = 0; i < count; i++) b[i] = a[i] > b[i] ? a[i] : b[i];     \
+        } else if (op == MPI_MIN) {                                           \
+            for (i = 0; i < count; i++) b[i] = a[i] < b[i] ? a[i] : b[i];     \
+        } else {                                                              \
+            for (i = 0; i < count; i++) b[i] = a[i] || b[i];                  \
+        }                                                                     \
+    }
+
+/* combineField() applies op to count elements of type: inout = in op inout.
+ */
+static inline void combineField(const void *in, void *inout, int count, MPI_Datatype type,
+                                MPI_Op op) {
+    if (type == MPI_INT) {
+        ASYNC_COMBINE(int)
+    } else if (type == MPI_LONG) {
+        ASYNC_COMBINE(long)
+    } else if (type == MPI_LONG_LONG) {
+        ASYNC_COMBINE(long long)
+    } else {
+        ASYNC_COMBINE(double)
+    }
+}
+
+/* fusedReduce() is the user op of the fused datatype: each field by its op.
+ *  The fields' layout is found through an attribute of the datatype.
+ */
+static inline void fusedReduce(void *in, void *inout, int *length, MPI_Datatype *type) {
+    asyncReduction *reduction;
+    int found = 0, e, f;
+
+    MPI_Type_get_attr(*type, asyncReductionKey, &reduction, &found);
+    if (!found) {
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    for (e = 0; e < *length; e++) {
+        char *from = (char *) in + e * reduction->bytes, *to = (char *) inout + e * reduction->bytes;
+        for (f = 0; f < reduction->numFields; f++) {
+            const reductionField *field = &reduction->fields[f];
+            combineField(from + field->offset, to + field->offset, field->count, field->type,
+                         field->op);
+        }
+    }
+}
+
+/* initAsyncReduction() makes reduction empty.
+ * parameters: hierarchical, 1 to reduce within nodes first.
+ */
+static inline void initAsyncReduction(asyncReduction *reduction, int hierarchical) {
+    memset(reduction, 0, sizeof(asyncReduction));
+    reduction->fused = MPI_DATATYPE_NULL;
+    reduction->op = MPI_OP_NULL;
+    reduction->request = MPI_REQUEST_NULL;
+    reduction->hierarchical = hierarchical;
+    reduction->node = reduction->leaders = MPI_COMM_NULL;
+    reduction->comm = MPI_COMM_WORLD;
+}
+
+/* addReductionField() adds an array to the reduction.
+ * parameters: data, the array; result, room for its reduction
+ *              (used on the root, or on every process for ASYNC_ALL);
+ *             count, its length; type and op, as above.
+ * Precondition: no start yet; reduction stays where it is from now on.
+ * return: 1; 0 if there is no room for it, or type or op is not supported.
+ */
+static inline int addReductionField(asyncReduction *reduction, const void *data, void *result,
+                                    int count, MPI_Datatype type, MPI_Op op) {
+    reductionField *field = &reduction->fields[reduction->numFields];
+    int size;
+
+    if (reduction->numFields == ASYNC_MAX_FIELDS || reduction->fused != MPI_DATATYPE_NULL
+        || (type != MPI_INT && type != MPI_LONG && type != MPI_LONG_LONG && type != MPI_DOUBLE)
+        || (op != MPI_SUM && op != MPI_MAX && op != MPI_MIN && op != MPI_LOR)
+        || (op == MPI_LOR && type == MPI_DOUBLE)) {
+        return 0;
+    }
+    MPI_Type_size(type, &size);
+    field->data = data;
+    field->result = result;
+    field->count = count;
+    field->type = type;
+    field->op = op;
+    field->offset = reduction->bytes;
+    reduction->bytes += ((MPI_Aint) count * size + 7) / 8 * 8;    // 8-byte aligned fields
+    reduction->numFields++;
+    return 1;
+}
+
+/* buildFusedReduction() makes the fused datatype and op, and the packed buffers.
+ */
+static inline void buildFusedReduction(asyncReduction *reduction) {
+    int lengths[ASYNC_MAX_FIELDS], f;
+    MPI_Aint offsets[ASYNC_MAX_FIELDS];
+    MPI_Datatype types[ASYNC_MAX_FIELDS], loose;
+
+    for (f = 0; f < reduction->numFields; f++) {
+        lengths[f] = reduction->fields[f].count;
+        offsets[f] = reduction->fields[f].offset;
+        types[f] = reduction->fields[f].type;
+    }
+    MPI_Type_create_struct(reduction->numFields, lengths, offsets, types, &loose);
+    MPI_Type_create_resized(loose, 0, reduction->bytes, &reduction->fused);
+    MPI_Type_free(&loose);
+    MPI_Type_commit(&reduction->fused);
+    if (asyncReductionKey == MPI_KEYVAL_INVALID) {
+        MPI_Type_create_keyval(MPI_TYPE_NULL_COPY_FN, MPI_TYPE_NULL_DELETE_FN,
+                               &asyncReductionKey, NULL);
+    }
+    MPI_Type_set_attr(reduction->fused, asyncReductionKey, reduction);
+    MPI_Op_create(fusedReduce, 1, &reduction->op);
+    reduction->send = (char *) calloc(reduction->bytes + 1, 1);
+    reduction->receive = (char *) calloc(reduction->bytes + 1, 1);
+    if (reduction->send == NULL || reduction->receive == NULL) {
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+}
+
+/* postReductionStage() posts the reduction's stage stage, or, past the last one,
+ *  unpacks the results and makes stage 0.
+ */
+static inline void postReductionStage(asyncReduction *reduction, int stage) {
+    int rank, f;
+    int everyone = reduction->root == ASYNC_ALL;
+
+    reduction->stage = stage;
+    reduction->request = MPI_REQUEST_NULL;
+    if (!reduction->hierarchical) {
+        if (stage == 1 && everyone) {
+            MPI_Iallreduce(reduction->send, reduction->receive, 1, reduction->fused, reduction->op,
+                           reduction->comm, &reduction->request);
+            return;
+        } else if (stage == 1) {
+            MPI_Ireduce(reduction->send, reduction->receive, 1, reduction->fused, reduction->op,
+                        reduction->root, reduction->comm, &reduction->request);
+            return;
+        }
+    } else {
+        if (stage == 1) {
+            MPI_Ireduce(reduction->send, reduction->receive, 1, reduction->fused, reduction->op,
+                        0, reduction->node, &reduction->request);
+            return;
+        } else if (stage == 2 && reduction->leaders != MPI_COMM_NULL) {
+            if (everyone) {
+                MPI_Iallreduce(MPI_IN_PLACE, reduction->receive, 1, reduction->fused,
+                               reduction->op, reduction->leaders, &reduction->request);
+            } else {
+                // the leader of node 0 is the root, process 0
+                MPI_Comm_rank(reduction->leaders, &rank);
+                MPI_Ireduce(rank == 0 ? MPI_IN_PLACE : reduction->receive,
+                            reduction->receive, 1, reduction->fused, reduction->op, 0,
+                            reduction->leaders, &reduction->request);
+            }
+            return;
+        } else if (stage == 2) {
+            return;    // nothing to do off the leaders; stage 3 next
+        } else if (stage == 3 && everyone) {
+            MPI_Ibcast(reduction->receive, 1, reduction->fused, 0, reduction->node,
+                       &reduction->request);
+            return;
+        }
+    }
+
+    // done
+    reduction->stage = 0;
+    reduction->inFlight += MPI_Wtime() - reduction->postedAt;
+    reduction->reductions++;
+    MPI_Comm_rank(reduction->comm, &rank);
+    if (everyone || rank == reduction->root) {
+        for (f = 0; f < reduction->numFields; f++) {
+            int size;
+            MPI_Type_size(reduction->fields[f].type, &size);
+            memcpy(reduction->fields[f].result, reduction->receive + reduction->fields[f].offset,
+                   (size_t) reduction->fields[f].count * size);
+        }
+    }
+}
+
+/* advanceAsyncReduction() waits for the stage in flight (or tests it, if !wait) and
+ *  posts the next stages that can be.
+ * return: 1 if the reduction is done (or none was started); 0 if not.
+ */
+static inline int advanceAsyncReduction(asyncReduction *reduction, int wait) {
+    int done = 0;
+
+    while (reduction->stage != 0) {
+        if (wait) {
+            MPI_Wait(&reduction->request, MPI_STATUS_IGNORE);
+        } else {
+            MPI_Test(&reduction->request, &done, MPI_STATUS_IGNORE);
+            if (!done) {
+                return 0;
+            }
+        }
+        postReductionStage(reduction, reduction->stage + 1);
+    }
+    return 1;
+}
+
+/* finishAsyncReduction() waits for the reduction in flight, if any.
+ * Postcondition: its results are in the fields' result arrays.
+ */
+static inline void finishAsyncReduction(asyncReduction *reduction) {
+    double start = MPI_Wtime();
+
+    if (reduction->stage != 0) {
+        advanceAsyncReduction(reduction, 1);
+        reduction->waited += MPI_Wtime() - start;
+    }
+}
+
+/* startAsyncReduction() packs the fields and starts reducing them.
+ *  A reduction still in flight is finished first.
+ * parameters: root, the process to get the results, or ASYNC_ALL;
+ *             comm, the processes to reduce over.
+ * Precondition: every process of comm calls this, with the same root
+ *  and comm each time, in the same order as its other collectives on comm.
+ */
+static inline void startAsyncReduction(asyncReduction *reduction, int root, MPI_Comm comm) {
+    int f;
+
+    finishAsyncReduction(reduction);
+    if (reduction->fused == MPI_DATATYPE_NULL) {
+        buildFusedReduction(reduction);
+    }
+    for (f = 0; f < reduction->numFields; f++) {
+        int size;
+        MPI_Type_size(reduction->fields[f].type, &size);
+        memcpy(reduction->send + reduction->fields[f].offset, reduction->fields[f].data,
+               (size_t) reduction->fields[f].count * size);
+    }
+    if (reduction->hierarchical && root != 0 && root != ASYNC_ALL) {
+        reduction->hierarchical = 0;    // the stages assume the root is a node's first process
+    }
+    if (reduction->hierarchical && reduction->node == MPI_COMM_NULL) {
+        const topology *where = getTopology(comm);
+        MPI_Comm_dup(where->node, &reduction->node);
+        if (where->leaders != MPI_COMM_NULL) {
+            MPI_Comm_dup(where->leaders, &reduction->leaders);
+        }
+    }
+    reduction->root = root;
+    reduction->comm = comm;
+    postReductionStage(reduction, 1);
+    // posting blocks the caller, so it is not time the reduction could hide
+    reduction->postedAt = MPI_Wtime();
+}
+
+/* progressAsyncReduction() moves the reduction in flight along; cheap
+ *  enough to call every few thousand iterations of a loop.
+ * return: 1 if it is done (or none was started), its results in place; 0 if not.
+ */
+static inline int progressAsyncReduction(asyncReduction *reduction) {
+    double start;
+    int done;
+
+    if (reduction->stage == 0) {
+        return 1;
+    }
+    start = MPI_Wtime();
+    done = advanceAsyncReduction(reduction, 0);
+    reduction->testing += MPI_Wtime() - start;
+    reduction->tests++;
+    return done;
+}
+
+/* reportAsyncReduction() prints, on process 0 of the last reduction's
+ *  communicator, the slowest process's totals (in flight, waited, and
+ *  the MPI_Test()s), and the least and most time, and share of its time
+ *  in flight, that a process hid behind computing.
+ * parameters: out, process 0's stream for it; NULL to print nothing.
+ * Precondition: every process of that communicator calls this.
+ */
+static inline void reportAsyncReduction(const asyncReduction *reduction, const char *label,
+                                        FILE *out) {
+    double hidden = reduction->inFlight > reduction->waited
+                    ? reduction->inFlight - reduction->waited : 0.0;
+    double share = reduction->inFlight > 0 ? 100 * hidden / reduction->inFlight : 0.0;
+    double mine[5] = {reduction->inFlight, reduction->waited, reduction->testing, hidden, share};
+    double most[5], least[2];
+    long tests = 0;
+    int rank;
+
+    MPI_Comm_rank(reduction->comm, &rank);
+    MPI_Reduce(mine, most, 5, MPI_DOUBLE, MPI_MAX, 0, reduction->comm);
+    MPI_Reduce(mine + 3, least, 2, MPI_DOUBLE, MPI_MIN, 0, reduction->comm);
+    MPI_Reduce((void *) &reduction->tests, &tests, 1, MPI_LONG, MPI_MAX, 0, reduction->comm);
+    if (rank == 0 && out != NULL) {
+        fprintf(out, "%s: %ld reductions of %ld bytes, %.6f s in flight, %.6f s waited, "
+               "%.6f to %.6f s hidden (%.0f%% to %.0f%%), %ld tests taking %.6f s\n", label,
+               reduction->reductions, (long) reduction->bytes, most[0], most[1], least[0],
+               most[3], least[1], most[4], tests, most[2]);
+        fflush(out);
+    }
+}
+
+/* freeAsyncReduction() finishes the reduction in flight and frees its
+ *  buffers (and communicators: every process of comm calls this).
+ */
+static inline void freeAsyncReduction(asyncReduction *reduction) {
+    finishAsyncReduction(reduction);
+    if (reduction->fused != MPI_DATATYPE_NULL) {
+        MPI_Type_free(&reduction->fused);
+        MPI_Op_free(&reduction->op);
+    }
+    if (reduction->node != MPI_COMM_NULL) {
+        MPI_Comm_free(&reduction->node);
+    }
+    if (reduction->leaders != MPI_COMM_NULL) {
+        MPI_Comm_free(&reduction->leaders);
+    }
+    free(reduction->send);
+    free(reduction->receive);
+    reduction->send = reduction->receive = NULL;
+}
+
+#undef ASYNC_COMBINE
+
+#endif
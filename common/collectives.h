@@ -0,0 +1,299 @@
+/* collectives.h gives MPI_Allreduce() alternatives, each with its exact
+ *  signature, so a program can keep a pointer to "its" allreduce and
+ *  switch algorithms by name (allreduceByName()) without other changes:
+ *
+ *  - ringAllreduce(): a ring reduce-scatter, then a ring allgather. Each
+ *     process sends about 2 * size of data in 2 * (P-1) steps, whatever P,
+ *     so it is the one for long vectors.
+ *  - recursiveDoublingAllreduce(): log2(P) exchanges of the whole vector
+ *     with the processes 1, 2, 4, ... away; fewest steps, so the one for
+ *     scalars and short vectors.
+ *  - hierarchicalAllreduce(): reduce within each node (through shared
+ *     memory), allreduce among one process per node, broadcast within
+ *     each node, so only one process per node uses the network.
+ *  - autoAllreduce(): picks one of the above by message size.
+ *  - hierarchicalReduce(): the hierarchical one for MPI_Reduce(), with its
+ *     signature: reduce within each node, then among one process per node.
+ *
+ * The nodes are those of topology.h, found on the first call on a
+ *  communicator and cached on it.
+ * The reductions use MPI_Reduce_local(), so any predefined or user
+ *  datatype and op work, MPI_IN_PLACE included; an op that does not
+ *  commute goes to MPI_Allreduce() (MPI_Reduce()), which keeps the order
+ *  of the ranks.
+ *  collectivesBenchmark times them all against MPI_Allreduce() and MPI_Reduce().
+ *
+ * Usage: #include "../common/collectives.h"    (C or C++)
+ *        allreduceFunction allreduce = allreduceByName(argv[1]);
+ *        allreduce(&mine, &sum, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+ */
+
+#ifndef COLLECTIVES
+#define COLLECTIVES
+
+#include <stdlib.h>    // malloc()
+#include <string.h>    // memcpy(), strcmp()
+#include <mpi.h>       // MPI functions
+#include "topology.h"  // getTopology()
+
+// the signature of MPI_Allreduce()
+typedef int (*allreduceFunction)(const void *sendbuf, void *recvbuf, int count,
+                                 MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
+
+// autoAllreduce() uses recursive doubling below this many bytes, the ring from it up
+#define ALLREDUCE_RING_BYTES (64 << 10)
+
+#define COLLECTIVE_TAG 7374    // the tag of the messages of this file
+
+/* startAllreduce() copies sendbuf to recvbuf (unless MPI_IN_PLACE), and
+ *  finds the extent of one element.
+ * return: 1 if op commutes, so the caller may reorder the reduction; 0 if not.
+ */
+static inline int startAllreduce(const void *sendbuf, void *recvbuf, int count,
+                                 MPI_Datatype datatype, MPI_Op op, MPI_Aint *extent) {
+    MPI_Aint lowerBound;
+    int commutes = 0;
+
+    MPI_Type_get_extent(datatype, &lowerBound, extent);
+    if (sendbuf != MPI_IN_PLACE && count > 0) {
+        memcpy(recvbuf, sendbuf, count * *extent);
+    }
+    MPI_Op_commutative(op, &commutes);
+    return commutes;
+}
+
+/* ringAllreduce() is MPI_Allreduce(), by a ring reduce-scatter (after
+ *  step s, process r has the sum over s+2 processes of block r-s-1) and
+ *  a ring allgather of the P reduced blocks.
+ */
+static inline int ringAllreduce(const void *sendbuf, void *recvbuf, int count,
+                                MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+    int rank, size, next, previous, step, block;
+    MPI_Aint extent;
+    char *data = (char *) recvbuf, *incoming;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    if (!startAllreduce(sendbuf, recvbuf, count, datatype, op, &extent)) {
+        return MPI_Allreduce(MPI_IN_PLACE, recvbuf, count, datatype, op, comm);
+    }
+    if (size == 1) {
+        return MPI_SUCCESS;
+    }
+    next = (rank + 1) % size;
+    previous = (rank + size - 1) % size;
+
+    // block b is elements first(b) .. first(b+1)-1, the first count % size blocks one longer
+#define BLOCK_FIRST(b) ((b) * (count / size) + ((b) < count % size ? (b) : count % size))
+#define BLOCK_COUNT(b) (BLOCK_FIRST((b) + 1) - BLOCK_FIRST(b))
+
+    incoming = (char *) malloc((count / size + 1) * extent);
+    if (incoming == NULL) {
+        return MPI_ERR_NO_MEM;
+    }
+
+    // reduce-scatter: pass block rank-step on, add in block rank-step-1
+    for (step = 0; step < size - 1; step++) {
+        int out = (rank - step + size) % size, in = (rank - step - 1 + size) % size;
+        MPI_Sendrecv(data + BLOCK_FIRST(out) * extent, BLOCK_COUNT(out), datatype, next,
+                     COLLECTIVE_TAG, incoming, BLOCK_COUNT(in), datatype, previous,
+                     COLLECTIVE_TAG, comm, MPI_STATUS_IGNORE);
+        MPI_Reduce_local(incoming, data + BLOCK_FIRST(in) * extent, BLOCK_COUNT(in),
+                         datatype, op);
+    }
+
+    // allgather: process r now has the sum of block r+1; pass the sums around
+    for (step = 0; step < size - 1; step++) {
+        int out = (rank + 1 - step + size) % size;
+        block = (rank - step + size) % size;
+        MPI_Sendrecv(data + BLOCK_FIRST(out) * extent, BLOCK_COUNT(out), datatype, next,
+                     COLLECTIVE_TAG, data + BLOCK_FIRST(block) * extent, BLOCK_COUNT(block),
+                     datatype, previous, COLLECTIVE_TAG, comm, MPI_STATUS_IGNORE);
+    }
+
+#undef BLOCK_FIRST
+#undef BLOCK_COUNT
+
+    free(incoming);
+    return MPI_SUCCESS;
+}
+
+/* recursiveDoublingAllreduce() is MPI_Allreduce(), by exchanging the
+ *  whole vector with the process 1, 2, 4, ... ranks away and adding it in.
+ *  When P is not a power of 2, the first 2 * (P - 2^k) processes first
+ *  pair up, and one of each pair sits out the exchanges and gets the
+ *  result from its partner at the end.
+ */
+static inline int recursiveDoublingAllreduce(const void *sendbuf, void *recvbuf, int count,
+                                             MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+    int rank, size, powerOf2 = 1, extra, newRank, mask;
+    MPI_Aint extent;
+    char *incoming;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    if (!startAllreduce(sendbuf, recvbuf, count, datatype, op, &extent)) {
+        return MPI_Allreduce(MPI_IN_PLACE, recvbuf, count, datatype, op, comm);
+    }
+    if (size == 1) {
+        return MPI_SUCCESS;
+    }
+    while (2 * powerOf2 <= size) {
+        powerOf2 *= 2;
+    }
+    extra = size - powerOf2;
+    incoming = (char *) malloc(count * extent + 1);
+    if (incoming == NULL) {
+        return MPI_ERR_NO_MEM;
+    }
+
+    // fold the extra processes into their odd partners
+    if (rank < 2 * extra) {
+        if (rank % 2 == 0) {
+            MPI_Send(recvbuf, count, datatype, rank + 1, COLLECTIVE_TAG, comm);
+            newRank = -1;
+        } else {
+            MPI_Recv(incoming, count, datatype, rank - 1, COLLECTIVE_TAG, comm, MPI_STATUS_IGNORE);
+            MPI_Reduce_local(incoming, recvbuf, count, datatype, op);
+            newRank = rank / 2;
+        }
+    } else {
+        newRank = rank - extra;
+    }
+
+    if (newRank >= 0) {
+        for (mask = 1; mask < powerOf2; mask *= 2) {
+            int partner = newRank ^ mask;
+            partner = partner < extra ? 2 * partner + 1 : partner + extra;
+            MPI_Sendrecv(recvbuf, count, datatype, partner, COLLECTIVE_TAG,
+                         incoming, count, datatype, partner, COLLECTIVE_TAG,
+                         comm, MPI_STATUS_IGNORE);
+            MPI_Reduce_local(incoming, recvbuf, count, datatype, op);
+        }
+    }
+
+    // and give them the result
+    if (rank < 2 * extra) {
+        if (rank % 2 == 0) {
+            MPI_Recv(recvbuf, count, datatype, rank + 1, COLLECTIVE_TAG, comm, MPI_STATUS_IGNORE);
+        } else {
+            MPI_Send(recvbuf, count, datatype, rank - 1, COLLECTIVE_TAG, comm);
+        }
+    }
+    free(incoming);
+    return MPI_SUCCESS;
+}
+
+/* hierarchicalAllreduce() is MPI_Allreduce(), by an MPI_Reduce() onto one
+ *  process per node, an allreduce among those (recursive doubling or
+ *  ring, by size), and an MPI_Bcast() back within each node.
+ */
+static inline int hierarchicalAllreduce(const void *sendbuf, void *recvbuf, int count,
+                                        MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+    const topology *where = getTopology(comm);
+    int typeSize, commutes = 0;
+
+    MPI_Op_commutative(op, &commutes);
+    if (!commutes) {
+        return MPI_Allreduce(sendbuf, recvbuf, count, datatype, op, comm);
+    }
+    if (sendbuf == MPI_IN_PLACE && where->nodeRank != 0) {
+        MPI_Reduce(recvbuf, NULL, count, datatype, op, 0, where->node);
+    } else {
+        MPI_Reduce(sendbuf, recvbuf, count, datatype, op, 0, where->node);
+    }
+    if (where->leaders != MPI_COMM_NULL) {
+        MPI_Type_size(datatype, &typeSize);
+        if ((long) count * typeSize < ALLREDUCE_RING_BYTES) {
+            recursiveDoublingAllreduce(MPI_IN_PLACE, recvbuf, count, datatype, op, where->leaders);
+        } else {
+            ringAllreduce(MPI_IN_PLACE, recvbuf, count, datatype, op, where->leaders);
+        }
+    }
+    return MPI_Bcast(recvbuf, count, datatype, 0, where->node);
+}
+
+/* hierarchicalReduce() is MPI_Reduce(), by an MPI_Reduce() onto the first
+ *  process of each node and one among those onto the first process of
+ *  root's node, which hands the result on to root if that is another
+ *  process. Only one process per node sends over the network.
+ */
+static inline int hierarchicalReduce(const void *sendbuf, void *recvbuf, int count,
+                                     MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm) {
+    const topology *where = getTopology(comm);
+    int rank, commutes = 0;
+    int rootAt[2];             // root's nodeId and nodeRank
+    MPI_Aint lowerBound, extent;
+    void *partial = recvbuf;   // where this node's sum goes
+
+    MPI_Op_commutative(op, &commutes);
+    if (!commutes) {
+        return MPI_Reduce(sendbuf, recvbuf, count, datatype, op, root, comm);
+    }
+    MPI_Comm_rank(comm, &rank);
+    findRoot(comm, root, rootAt);
+
+    if (where->nodeRank != 0) {
+        // MPI_IN_PLACE can only be root's, and root's data is in recvbuf then
+        MPI_Reduce(sendbuf == MPI_IN_PLACE ? recvbuf : sendbuf, NULL, count, datatype, op,
+                   0, where->node);
+    } else {
+        if (rank != root) {
+            MPI_Type_get_extent(datatype, &lowerBound, &extent);
+            partial = malloc(count * extent + 1);
+            if (partial == NULL) {
+                return MPI_ERR_NO_MEM;
+            }
+        }
+        MPI_Reduce(sendbuf, partial, count, datatype, op, 0, where->node);
+        MPI_Reduce(where->nodeId == rootAt[0] ? MPI_IN_PLACE : partial, partial, count,
+                   datatype, op, rootAt[0], where->leaders);
+    }
+
+    if (rootAt[1] != 0 && where->nodeId == rootAt[0]) {
+        if (where->nodeRank == 0) {
+            MPI_Send(partial, count, datatype, rootAt[1], COLLECTIVE_TAG, where->node);
+        } else if (rank == root) {
+            MPI_Recv(recvbuf, count, datatype, 0, COLLECTIVE_TAG, where->node, MPI_STATUS_IGNORE);
+        }
+    }
+    if (partial != recvbuf) {
+        free(partial);
+    }
+    return MPI_SUCCESS;
+}
+
+/* autoAllreduce() is MPI_Allreduce(), by recursive doubling for messages
+ *  shorter than ALLREDUCE_RING_BYTES and by the ring for longer ones.
+ */
+static inline int autoAllreduce(const void *sendbuf, void *recvbuf, int count,
+                                MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+    int typeSize;
+
+    MPI_Type_size(datatype, &typeSize);
+    if ((long) count * typeSize < ALLREDUCE_RING_BYTES) {
+        return recursiveDoublingAllreduce(sendbuf, recvbuf, count, datatype, op, comm);
+    }
+    return ringAllreduce(sendbuf, recvbuf, count, datatype, op, comm);
+}
+
+/* allreduceByName() looks an allreduce up by name: "mpi", "ring",
+ *  "doubling", "hierarchical" or "auto".
+ * return: the function; MPI_Allreduce for NULL or an unknown name.
+ */
+static inline allreduceFunction allreduceByName(const char *name) {
+    if (name == NULL) {
+        return MPI_Allreduce;
+    } else if (strcmp(name, "ring") == 0) {
+        return ringAllreduce;
+    } else if (strcmp(name, "doubling") == 0) {
+        return recursiveDoublingAllreduce;
+    } else if (strcmp(name, "hierarchical") == 0) {
+        return hierarchicalAllreduce;
+    } else if (strcmp(name, "auto") == 0) {
+        return autoAllreduce;
+    }
+    return MPI_Allreduce;
+}
+
+#endif
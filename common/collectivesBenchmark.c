@@ -0,0 +1,149 @@
+/* collectivesBenchmark.c
+ *
+ * Times the allreduces of collectives.h against MPI_Allreduce() (and
+ * hierarchicalReduce() against MPI_Reduce(), which only process 0 gets
+ * the result of) for vectors of
+ * 1, 2, 4, ... doubles, plus the 101 of firestarter's burn-percentage
+ * table, and names the fastest allreduce for each size, so a program can
+ * pick its algorithm (or tune ALLREDUCE_RING_BYTES) for the sizes it uses.
+ * Every result is checked against MPI_Allreduce() first.
+ *
+ * Usage: mpirun -np N ./collectivesBenchmark [-n maxDoubles]
+ *   -n  the longest vector (default 2M doubles, 16 MiB)
+ */
+
+#include <stdio.h>     // printf()
+#include <stdlib.h>    // malloc(), atol()
+#include <string.h>    // strcmp(), memcmp()
+#include <mpi.h>       // MPI functions
+#include "collectives.h" // ringAllreduce(), ...
+
+#define MAX_COUNT      (1 << 21)    // doubles
+#define FIRESTARTER    101          // the length of firestarter's vectors
+#define TEST_BYTES     (1L << 27)   // about this many bytes reduced per size...
+#define MIN_ITERATIONS 5            // ... but at least this many iterations
+#define MAX_ITERATIONS 1000         // and at most this many
+
+// MPI_Reduce(), to the root 0, as an allreduce-shaped function
+static int reduceToRoot(const void *sendbuf, void *recvbuf, int count,
+                        MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+    return MPI_Reduce(sendbuf, recvbuf, count, datatype, op, 0, comm);
+}
+
+// and hierarchicalReduce()
+static int hierarchicalToRoot(const void *sendbuf, void *recvbuf, int count,
+                              MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+    return hierarchicalReduce(sendbuf, recvbuf, count, datatype, op, 0, comm);
+}
+
+static const char *names[] = {"MPI_Reduce", "hier. reduce", "MPI_Allreduce", "ring",
+                              "doubling", "hierarchical", "auto"};
+#define NUM_ALGORITHMS 7
+#define FIRST_ALLREDUCE 2    // the ones before only reduce
+
+/* timeAllreduce() times iterations calls of allreduce, after a few warm-ups.
+ * return: on process 0, the seconds per call of the slowest process.
+ */
+double timeAllreduce(allreduceFunction allreduce, const double *data, double *sums,
+                     int count, int iterations) {
+    double seconds = 0.0, slowest = 0.0;
+    int i;
+
+    for (i = -(iterations / 10 + 1); i < iterations; i++) {
+        if (i == 0) {
+            MPI_Barrier(MPI_COMM_WORLD);
+            seconds = MPI_Wtime();
+        }
+        allreduce(data, sums, count, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    }
+    seconds = MPI_Wtime() - seconds;
+    MPI_Reduce(&seconds, &slowest, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    return slowest / iterations;
+}
+
+int main(int argc, char *argv[]) {
+    int id, numProcesses, a, i;
+    long maxCount = MAX_COUNT, count;
+    double *data, *sums, *expected;
+    double seconds[NUM_ALGORITHMS];
+    allreduceFunction functions[NUM_ALGORITHMS];
+    int wrong = 0, best;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            maxCount = atol(argv[++i]);
+        }
+    }
+    if (maxCount < FIRESTARTER) {
+        maxCount = FIRESTARTER;
+    }
+    functions[0] = reduceToRoot;
+    functions[1] = hierarchicalToRoot;
+    for (a = FIRST_ALLREDUCE; a < NUM_ALGORITHMS; a++) {
+        functions[a] = allreduceByName(names[a]);    // MPI_Allreduce for "MPI_Allreduce"
+    }
+
+    // small integers, so every order of summing them gives the same sums
+    data = (double *) malloc(maxCount * sizeof(double));
+    sums = (double *) malloc(maxCount * sizeof(double));
+    expected = (double *) malloc(maxCount * sizeof(double));
+    if (!data || !sums || !expected) {
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    for (i = 0; i < maxCount; i++) {
+        data[i] = (double) ((id * 31 + i) % 1000);
+    }
+
+    if (id == 0) {
+        printf("%d processes; microseconds per call of the slowest process\n", numProcesses);
+        printf("%10s %10s", "doubles", "bytes");
+        for (a = 0; a < NUM_ALGORITHMS; a++) {
+            printf(" %13s", names[a]);
+        }
+        printf("  fastest allreduce\n");
+    }
+
+    for (count = 1; count <= maxCount; count = count == 64 ? FIRESTARTER
+                                               : count == FIRESTARTER ? 128 : 2 * count) {
+        long iterations = TEST_BYTES / (count * (long) sizeof(double));
+        iterations = iterations < MIN_ITERATIONS ? MIN_ITERATIONS
+                     : iterations > MAX_ITERATIONS ? MAX_ITERATIONS : iterations;
+
+        // check them all first (the reduces on process 0 only)
+        MPI_Allreduce(data, expected, (int) count, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        for (a = 0; a < NUM_ALGORITHMS; a++) {
+            memset(sums, 0, count * sizeof(double));
+            functions[a](data, sums, (int) count, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+            if ((a >= FIRST_ALLREDUCE || id == 0)
+                && memcmp(sums, expected, count * sizeof(double)) != 0) {
+                fprintf(stderr, "process %d: %s is wrong for %ld doubles\n", id, names[a], count);
+                wrong = 1;
+            }
+        }
+
+        for (a = 0; a < NUM_ALGORITHMS; a++) {
+            seconds[a] = timeAllreduce(functions[a], data, sums, (int) count, (int) iterations);
+        }
+        if (id == 0) {
+            best = FIRST_ALLREDUCE;
+            printf("%10ld %10ld", count, count * (long) sizeof(double));
+            for (a = 0; a < NUM_ALGORITHMS; a++) {
+                printf(" %13.2f", seconds[a] * 1e6);
+                if (a >= FIRST_ALLREDUCE && seconds[a] < seconds[best]) {
+                    best = a;
+                }
+            }
+            printf("  %s\n", names[best]);
+            fflush(stdout);
+        }
+    }
+
+    free(data);
+    free(sums);
+    free(expected);
+    MPI_Finalize();
+    return wrong;
+}
@@ -0,0 +1,261 @@
+/* neighborExchange.h exchanges halos (the edges of each process's block)
+ *  with a fixed set of neighbors, step after step, without setting the
+ *  messages up again each step.
+ *
+ * Each neighbor is a link: what to send it and where to receive what it
+ *  sends, as buffer, count and datatype (a strided MPI_Type_vector() for a
+ *  column is fine). A Cartesian communicator (cartComm(), MPI_Cart_create())
+ *  gives the links of a dimension with addCartShift(); any other set of
+ *  neighbors is added one by one with addNeighbor(). The buffers must stay
+ *  where they are: it is their contents that change from step to step.
+ *
+ * startNeighborExchange() posts one step's messages, so a program can
+ *  update its interior while they travel, and finishNeighborExchange()
+ *  waits for them. How they are posted is the exchange's mode:
+ *  - NEIGHBOR_PERSISTENT: an MPI_Recv_init()/MPI_Send_init() per link,
+ *     made on the first start and MPI_Startall()ed on each later one;
+ *  - NEIGHBOR_COLLECTIVE: one MPI_Ineighbor_alltoallw() (the datatype-
+ *     per-neighbor MPI_Neighbor_alltoallv()) on a distributed-graph
+ *     communicator of the links, made on the first start, so the MPI
+ *     library may schedule the messages itself.
+ * Either way every neighbor's messages are in flight at once, so no pair
+ *  waits for another, as ordered MPI_Send()/MPI_Recv() pairs do.
+ *
+ * On a periodic dimension of 1 or 2 processes one neighbor is both the
+ *  low and the high one. NEIGHBOR_PERSISTENT tells the two apart by a tag
+ *  per direction; in NEIGHBOR_COLLECTIVE mode a neighbor may appear in only
+ *  one link. MPI_PROC_NULL neighbors, at the edges of a non-periodic grid,
+ *  are skipped in both modes.
+ *
+ * Usage: #include "../common/neighborExchange.h"    (C or C++)
+ *        neighborExchange halo;
+ *        initNeighborExchange(&halo, cart, NEIGHBOR_PERSISTENT);
+ *        addCartShift(&halo, 0, firstRow, topHalo, lastRow, bottomHalo, cols, MPI_DOUBLE);
+ *        for (...) {
+ *            startNeighborExchange(&halo);  ... update the interior ...
+ *            finishNeighborExchange(&halo); ... update the edges ...
+ *        }
+ *        freeNeighborExchange(&halo);
+ */
+
+#ifndef NEIGHBOR_EXCHANGE
+#define NEIGHBOR_EXCHANGE
+
+#include <mpi.h>       // MPI functions
+
+#define NEIGHBOR_MAX  26    // links; the 3D Moore neighborhood
+#define NEIGHBOR_TAG  7380  // 7380 .. 7386, clear of the other headers' tags
+
+enum { NEIGHBOR_PERSISTENT, NEIGHBOR_COLLECTIVE };
+
+typedef struct {
+    int rank;                    // in comm; MPI_PROC_NULL for none
+    int sendTag, receiveTag;
+    void *send, *receive;
+    int sendCount, receiveCount;
+    MPI_Datatype sendType, receiveType;
+} neighborLink;
+
+typedef struct {
+    MPI_Comm comm;
+    int mode;
+    int numLinks;
+    neighborLink links[NEIGHBOR_MAX];
+    int ready;                   // the requests or the graph are made
+    // NEIGHBOR_PERSISTENT: the receives, then the sends
+    int numRequests;
+    MPI_Request requests[2 * NEIGHBOR_MAX];
+    // NEIGHBOR_COLLECTIVE: the links, as MPI_Ineighbor_alltoallw() takes them
+    MPI_Comm graph;
+    MPI_Request request;
+    int sendCounts[NEIGHBOR_MAX], receiveCounts[NEIGHBOR_MAX];
+    MPI_Aint sendAt[NEIGHBOR_MAX], receiveAt[NEIGHBOR_MAX];
+    MPI_Datatype sendTypes[NEIGHBOR_MAX], receiveTypes[NEIGHBOR_MAX];
+} neighborExchange;
+
+/* cartComm() lays comm's processes out on a Cartesian grid of as square a
+ *  shape as MPI_Dims_create() finds.
+ * parameters: ndims, the grid's dimensions (at most 3);
+ *             periodic, whether they wrap around (for all of them);
+ *             dims, for the processes along each dimension.
+ * return: the Cartesian communicator, reordered as MPI sees fit;
+ *         MPI_Comm_free() it when done.
+ */
+static inline MPI_Comm cartComm(MPI_Comm comm, int ndims, int periodic, int *dims) {
+    int numProcesses, periods[3], d;
+    MPI_Comm cart;
+
+    MPI_Comm_size(comm, &numProcesses);
+    for (d = 0; d < ndims; d++) {
+        dims[d] = 0;
+        periods[d] = periodic;
+    }
+    MPI_Dims_create(numProcesses, ndims, dims);
+    MPI_Cart_create(comm, ndims, dims, periods, 1, &cart);
+    return cart;
+}
+
+/* initNeighborExchange() makes an exchange with no links yet.
+ * parameters: comm, the communicator the neighbors' ranks are in;
+ *             mode, NEIGHBOR_PERSISTENT or NEIGHBOR_COLLECTIVE.
+ */
+static inline void initNeighborExchange(neighborExchange *exchange, MPI_Comm comm, int mode) {
+    exchange->comm = comm;
+    exchange->mode = mode;
+    exchange->numLinks = 0;
+    exchange->ready = 0;
+    exchange->numRequests = 0;
+    exchange->graph = MPI_COMM_NULL;
+    exchange->request = MPI_REQUEST_NULL;
+}
+
+/* addNeighbor() adds a link: each step, send's data goes to rank, and
+ *  rank's data comes into receive.
+ * Precondition: rank adds the matching link to this process, and the
+ *  exchange has not been started.
+ * return: 1; 0 if it already has NEIGHBOR_MAX links.
+ */
+static inline int addNeighbor(neighborExchange *exchange, int rank,
+                              void *send, int sendCount, MPI_Datatype sendType,
+                              void *receive, int receiveCount, MPI_Datatype receiveType) {
+    neighborLink *link;
+
+    if (exchange->numLinks == NEIGHBOR_MAX) {
+        return 0;
+    }
+    link = &exchange->links[exchange->numLinks++];
+    link->rank = rank;
+    link->sendTag = link->receiveTag = NEIGHBOR_TAG;
+    link->send = send;
+    link->sendCount = sendCount;
+    link->sendType = sendType;
+    link->receive = receive;
+    link->receiveCount = receiveCount;
+    link->receiveType = receiveType;
+    return 1;
+}
+
+/* addCartShift() adds the two links along one dimension of a Cartesian
+ *  communicator: lowSend goes to the neighbor below (MPI_Cart_shift() by
+ *  -1) and its data comes into lowReceive; likewise for the one above.
+ * Precondition: the exchange's comm is Cartesian, and every process of it
+ *  adds its shifts in the same order.
+ * return: 1; 0 if there is no room for both links.
+ */
+static inline int addCartShift(neighborExchange *exchange, int direction,
+                               void *lowSend, void *lowReceive,
+                               void *highSend, void *highReceive,
+                               int count, MPI_Datatype type) {
+    int low, high;
+
+    if (exchange->numLinks + 2 > NEIGHBOR_MAX) {
+        return 0;
+    }
+    MPI_Cart_shift(exchange->comm, direction, 1, &low, &high);
+    addNeighbor(exchange, low, lowSend, count, type, lowReceive, count, type);
+    addNeighbor(exchange, high, highSend, count, type, highReceive, count, type);
+
+    // a tag for data going down the dimension and one for data going up
+    exchange->links[exchange->numLinks - 2].sendTag = NEIGHBOR_TAG + 2 * direction + 1;
+    exchange->links[exchange->numLinks - 2].receiveTag = NEIGHBOR_TAG + 2 * direction + 2;
+    exchange->links[exchange->numLinks - 1].sendTag = NEIGHBOR_TAG + 2 * direction + 2;
+    exchange->links[exchange->numLinks - 1].receiveTag = NEIGHBOR_TAG + 2 * direction + 1;
+    return 1;
+}
+
+/* prepareNeighborExchange() makes the persistent requests, or the graph
+ *  communicator and the argument arrays, of the exchange's links.
+ * Precondition: every process of comm calls this (from its first start).
+ */
+static inline void prepareNeighborExchange(neighborExchange *exchange) {
+    int ranks[NEIGHBOR_MAX], weights[NEIGHBOR_MAX], numNeighbors = 0, i;
+    neighborLink *link;
+
+    if (exchange->mode == NEIGHBOR_PERSISTENT) {
+        for (i = 0; i < exchange->numLinks; i++) {
+            link = &exchange->links[i];
+            if (link->rank != MPI_PROC_NULL) {
+                MPI_Recv_init(link->receive, link->receiveCount, link->receiveType, link->rank,
+                              link->receiveTag, exchange->comm,
+                              &exchange->requests[exchange->numRequests++]);
+            }
+        }
+        for (i = 0; i < exchange->numLinks; i++) {
+            link = &exchange->links[i];
+            if (link->rank != MPI_PROC_NULL) {
+                MPI_Send_init(link->send, link->sendCount, link->sendType, link->rank,
+                              link->sendTag, exchange->comm,
+                              &exchange->requests[exchange->numRequests++]);
+            }
+        }
+    } else {
+        // absolute addresses, from MPI_BOTTOM, since each link has its own buffer
+        for (i = 0; i < exchange->numLinks; i++) {
+            link = &exchange->links[i];
+            if (link->rank != MPI_PROC_NULL) {
+                ranks[numNeighbors] = link->rank;
+                weights[numNeighbors] = 1;
+                exchange->sendCounts[numNeighbors] = link->sendCount;
+                exchange->receiveCounts[numNeighbors] = link->receiveCount;
+                exchange->sendTypes[numNeighbors] = link->sendType;
+                exchange->receiveTypes[numNeighbors] = link->receiveType;
+                MPI_Get_address(link->send, &exchange->sendAt[numNeighbors]);
+                MPI_Get_address(link->receive, &exchange->receiveAt[numNeighbors]);
+                numNeighbors++;
+            }
+        }
+        // equal weights rather than MPI_UNWEIGHTED, a sentinel pointer some compilers flag
+        MPI_Dist_graph_create_adjacent(exchange->comm, numNeighbors, ranks, weights,
+                                       numNeighbors, ranks, weights, MPI_INFO_NULL, 0,
+                                       &exchange->graph);
+    }
+    exchange->ready = 1;
+}
+
+/* startNeighborExchange() posts one step's messages to and from every
+ *  neighbor.
+ * Precondition: every process of comm calls this, the same number of
+ *  times, and the previous step is finished.
+ */
+static inline void startNeighborExchange(neighborExchange *exchange) {
+    if (!exchange->ready) {
+        prepareNeighborExchange(exchange);
+    }
+    if (exchange->mode == NEIGHBOR_PERSISTENT) {
+        MPI_Startall(exchange->numRequests, exchange->requests);
+    } else {
+        MPI_Ineighbor_alltoallw(MPI_BOTTOM, exchange->sendCounts, exchange->sendAt,
+                                exchange->sendTypes, MPI_BOTTOM, exchange->receiveCounts,
+                                exchange->receiveAt, exchange->receiveTypes, exchange->graph,
+                                &exchange->request);
+    }
+}
+
+/* finishNeighborExchange() waits for the step's messages.
+ * Postcondition: every receive buffer holds its neighbor's data, and every
+ *  send buffer may be changed.
+ */
+static inline void finishNeighborExchange(neighborExchange *exchange) {
+    if (exchange->mode == NEIGHBOR_PERSISTENT) {
+        MPI_Waitall(exchange->numRequests, exchange->requests, MPI_STATUSES_IGNORE);
+    } else {
+        MPI_Wait(&exchange->request, MPI_STATUS_IGNORE);
+    }
+}
+
+/* freeNeighborExchange() frees the requests or the graph communicator.
+ * Precondition: every process of comm calls this, its last step finished.
+ */
+static inline void freeNeighborExchange(neighborExchange *exchange) {
+    int i;
+
+    for (i = 0; i < exchange->numRequests; i++) {
+        MPI_Request_free(&exchange->requests[i]);
+    }
+    if (exchange->graph != MPI_COMM_NULL) {
+        MPI_Comm_free(&exchange->graph);
+    }
+    initNeighborExchange(exchange, exchange->comm, exchange->mode);
+}
+
+#endif
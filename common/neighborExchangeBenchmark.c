@@ -0,0 +1,228 @@
+/* neighborExchangeBenchmark.c
+ *
+ * Times the halo exchange of a 2D Jacobi stencil (each cell becomes the
+ * average of its four neighbors) on a Cartesian grid of blocks, done three
+ * ways: MPI_Irecv()/MPI_Isend() set up anew each step, the persistent
+ * requests of neighborExchange.h, and its MPI_Ineighbor_alltoallw(). Each
+ * step updates the block's interior while its halo travels, and its edges
+ * once the halo is in. The grids are double buffered, so each way needs
+ * one exchange per buffer, made once. All three must end with the same
+ * grid, to the bit.
+ *
+ * Usage: mpirun -np N ./neighborExchangeBenchmark [-n gridSize] [-s steps] [-p]
+ *   -n  the grid is gridSize x gridSize cells (default 1024)
+ *   -s  the steps of the stencil (default 200)
+ *   -p  the grid wraps around (periodic); otherwise its border stays 0
+ */
+
+#include <stdio.h>     // printf()
+#include <stdlib.h>    // calloc(), atol()
+#include <string.h>    // strcmp()
+#include <mpi.h>       // MPI functions
+#include "neighborExchange.h" // cartComm(), startNeighborExchange(), ...
+
+#define TAG_TO_LOW  1            // sent to the north or west neighbor
+#define TAG_TO_HIGH 2            // and to the south or east one
+
+enum { ISEND_IRECV, PERSISTENT, COLLECTIVE, NUM_WAYS };
+
+typedef struct {
+    int rows, cols;
+    long firstRow, firstCol;
+    double *grid[2];            // (rows+2) x (cols+2), halo included
+    MPI_Datatype column;
+} block;
+
+// cell (i,j) of grid g, with the halo at i,j = -1 and rows/cols
+#define AT(b, g, i, j) ((b)->grid[g][(size_t) ((i) + 1) * ((b)->cols + 2) + ((j) + 1)])
+
+/* blockRange() splits n cells among parts, the first n % parts one more.
+ */
+void blockRange(long n, int parts, int index, long *first, long *count) {
+    long chunk = n / parts, remainder = n % parts;
+
+    *count = chunk + (index < remainder);
+    *first = index * chunk + (index < remainder ? index : remainder);
+}
+
+/* fill() sets grid 0 of b to the same pattern whatever the process grid,
+ *  and both halos to 0.
+ */
+void fill(block *b) {
+    int i, j;
+
+    memset(b->grid[0], 0, (size_t) (b->rows + 2) * (b->cols + 2) * sizeof(double));
+    memset(b->grid[1], 0, (size_t) (b->rows + 2) * (b->cols + 2) * sizeof(double));
+    for (i = 0; i < b->rows; i++) {
+        for (j = 0; j < b->cols; j++) {
+            AT(b, 0, i, j) = (double) (((b->firstRow + i) * 7 + (b->firstCol + j) * 13) % 101);
+        }
+    }
+}
+
+/* relax() computes cell (i,j) of grid 1-g from grid g.
+ */
+static inline void relax(block *b, int g, int i, int j) {
+    AT(b, 1 - g, i, j) = 0.25 * (AT(b, g, i - 1, j) + AT(b, g, i + 1, j) +
+                                 AT(b, g, i, j - 1) + AT(b, g, i, j + 1));
+}
+
+/* postHalo() is the halo exchange without neighborExchange.h: eight
+ *  requests of grid g, set up for this step alone.
+ */
+void postHalo(block *b, int g, MPI_Comm cart, MPI_Request *requests) {
+    int north, south, west, east, rows = b->rows, cols = b->cols;
+
+    MPI_Cart_shift(cart, 0, 1, &north, &south);
+    MPI_Cart_shift(cart, 1, 1, &west, &east);
+    MPI_Irecv(&AT(b, g, -1, 0), cols, MPI_DOUBLE, north, TAG_TO_HIGH, cart, &requests[0]);
+    MPI_Irecv(&AT(b, g, rows, 0), cols, MPI_DOUBLE, south, TAG_TO_LOW, cart, &requests[1]);
+    MPI_Irecv(&AT(b, g, 0, -1), 1, b->column, west, TAG_TO_HIGH, cart, &requests[2]);
+    MPI_Irecv(&AT(b, g, 0, cols), 1, b->column, east, TAG_TO_LOW, cart, &requests[3]);
+    MPI_Isend(&AT(b, g, 0, 0), cols, MPI_DOUBLE, north, TAG_TO_LOW, cart, &requests[4]);
+    MPI_Isend(&AT(b, g, rows - 1, 0), cols, MPI_DOUBLE, south, TAG_TO_HIGH, cart, &requests[5]);
+    MPI_Isend(&AT(b, g, 0, 0), 1, b->column, west, TAG_TO_LOW, cart, &requests[6]);
+    MPI_Isend(&AT(b, g, 0, cols - 1), 1, b->column, east, TAG_TO_HIGH, cart, &requests[7]);
+}
+
+/* run() does the stencil's steps one way.
+ * return: the grid's checksum, on process 0.
+ */
+double run(block *b, MPI_Comm cart, int way, long steps) {
+    neighborExchange halo[2];
+    MPI_Request requests[8];
+    double sum = 0.0, total = 0.0;
+    long step;
+    int g, i, j;
+
+    for (g = 0; way != ISEND_IRECV && g < 2; g++) {
+        initNeighborExchange(&halo[g], cart, way == PERSISTENT ? NEIGHBOR_PERSISTENT
+                                                                : NEIGHBOR_COLLECTIVE);
+        addCartShift(&halo[g], 0, &AT(b, g, 0, 0), &AT(b, g, -1, 0),
+                     &AT(b, g, b->rows - 1, 0), &AT(b, g, b->rows, 0), b->cols, MPI_DOUBLE);
+        addCartShift(&halo[g], 1, &AT(b, g, 0, 0), &AT(b, g, 0, -1),
+                     &AT(b, g, 0, b->cols - 1), &AT(b, g, 0, b->cols), 1, b->column);
+    }
+
+    for (step = 0, g = 0; step < steps; step++, g = 1 - g) {
+        if (way == ISEND_IRECV) {
+            postHalo(b, g, cart, requests);
+        } else {
+            startNeighborExchange(&halo[g]);
+        }
+        for (i = 1; i < b->rows - 1; i++) {
+            for (j = 1; j < b->cols - 1; j++) {
+                relax(b, g, i, j);
+            }
+        }
+        if (way == ISEND_IRECV) {
+            MPI_Waitall(8, requests, MPI_STATUSES_IGNORE);
+        } else {
+            finishNeighborExchange(&halo[g]);
+        }
+        for (i = 0; i < b->rows; i++) {
+            int stride = (i == 0 || i == b->rows - 1 || b->cols < 2) ? 1 : b->cols - 1;
+            for (j = 0; j < b->cols; j += stride) {
+                relax(b, g, i, j);
+            }
+        }
+    }
+
+    for (g = 0; way != ISEND_IRECV && g < 2; g++) {
+        freeNeighborExchange(&halo[g]);
+    }
+    g = steps % 2;
+    for (i = 0; i < b->rows; i++) {
+        for (j = 0; j < b->cols; j++) {
+            sum += AT(b, g, i, j) * (1.0 + ((b->firstRow + i) * 3 + (b->firstCol + j)) % 17);
+        }
+    }
+    MPI_Reduce(&sum, &total, 1, MPI_DOUBLE, MPI_SUM, 0, cart);
+    return total;
+}
+
+int main(int argc, char *argv[]) {
+    const char *names[NUM_WAYS] = {"Isend/Irecv", "persistent", "neighbor coll."};
+    int id, numProcesses, i, way, dims[2], coords[2], periodic = 0, wrong = 0, canCollect;
+    long gridSize = 1024, steps = 200, first, count;
+    double start, seconds, slowest, checksum[NUM_WAYS];
+    MPI_Comm cart;
+    block b;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            gridSize = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            steps = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-p") == 0) {
+            periodic = 1;
+        }
+    }
+
+    cart = cartComm(MPI_COMM_WORLD, 2, periodic, dims);
+    MPI_Comm_rank(cart, &id);
+    MPI_Cart_coords(cart, id, 2, coords);
+    if (gridSize < dims[0] || gridSize < dims[1]) {
+        if (id == 0) {
+            fprintf(stderr, "*** gridSize (%ld) must be at least %d x %d\n", gridSize,
+                    dims[0], dims[1]);
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    blockRange(gridSize, dims[0], coords[0], &first, &count);
+    b.firstRow = first;
+    b.rows = (int) count;
+    blockRange(gridSize, dims[1], coords[1], &first, &count);
+    b.firstCol = first;
+    b.cols = (int) count;
+    b.grid[0] = (double *) calloc((size_t) (b.rows + 2) * (b.cols + 2), sizeof(double));
+    b.grid[1] = (double *) calloc((size_t) (b.rows + 2) * (b.cols + 2), sizeof(double));
+    if (b.grid[0] == NULL || b.grid[1] == NULL) {
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    MPI_Type_vector(b.rows, 1, b.cols + 2, MPI_DOUBLE, &b.column);
+    MPI_Type_commit(&b.column);
+
+    // a periodic dimension of 1 or 2 processes has one neighbor both ways
+    canCollect = !periodic || (dims[0] > 2 && dims[1] > 2);
+    if (id == 0) {
+        printf("%ld x %ld grid%s on a %d x %d process grid, %ld steps; "
+               "seconds of the slowest process\n", gridSize, gridSize,
+               periodic ? " (periodic)" : "", dims[0], dims[1], steps);
+        printf("%-15s %12s %12s %18s\n", "exchange", "seconds", "per step", "checksum");
+    }
+
+    for (way = 0; way < NUM_WAYS; way++) {
+        if (way == COLLECTIVE && !canCollect) {
+            if (id == 0) {
+                printf("%-15s %12s (a neighbor both ways; needs -p off or 3+ x 3+ processes)\n",
+                       names[way], "-");
+            }
+            continue;
+        }
+        fill(&b);
+        MPI_Barrier(cart);
+        start = MPI_Wtime();
+        checksum[way] = run(&b, cart, way, steps);
+        seconds = MPI_Wtime() - start;
+        MPI_Reduce(&seconds, &slowest, 1, MPI_DOUBLE, MPI_MAX, 0, cart);
+        if (id == 0) {
+            if (checksum[way] != checksum[ISEND_IRECV]) {
+                wrong = 1;
+            }
+            printf("%-15s %12.6f %12.2e %18.6f%s\n", names[way], slowest,
+                   steps > 0 ? slowest / steps : 0.0, checksum[way],
+                   checksum[way] != checksum[ISEND_IRECV] ? "  WRONG" : "");
+        }
+    }
+
+    MPI_Type_free(&b.column);
+    free(b.grid[0]);
+    free(b.grid[1]);
+    MPI_Comm_free(&cart);
+    MPI_Finalize();
+    return wrong;
+}
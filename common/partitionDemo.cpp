@@ -0,0 +1,121 @@
+/* partitionDemo.cpp shows Partition.h at work, and checks it:
+ *  for each layout it scatters an array from process 0, has each process
+ *  double its items (with forEachOwned(), so it knows where they were),
+ *  gathers them back, and then moves them from a BLOCK partition into
+ *  the layout's and back, comparing every item with what it should be.
+ *  The scatter is begun with iscatter() and the loop's table initialized
+ *  while it is in flight.
+ *
+ * Usage: mpirun -np N ./partitionDemo [numItems(1000003)] [blockSize(64)]
+ */
+
+#include <stdio.h>     // printf()
+#include <stdlib.h>    // atoll()
+#include <vector>      // C++ vector
+#include <mpi.h>       // MPI library
+#include "Partition.h" // Partition
+
+typedef long long Item;
+
+int main(int argc, char *argv[])
+{
+    int id, numProcs, wrong = 0;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &numProcs);
+    long long numItems = argc > 1 ? atoll(argv[1]) : 1000003;
+    long long blockSize = argc > 2 ? atoll(argv[2]) : 64;
+
+    std::vector<Item> all, result;
+    if (id == 0)
+    {
+        all.resize(numItems);
+        result.resize(numItems);
+        for (long long i = 0; i < numItems; i++)
+        {
+            all[i] = 3 * i + 1;
+        }
+    }
+
+    // the faster processes (here, the even ones) get twice the items
+    std::vector<double> weights(numProcs);
+    for (int r = 0; r < numProcs; r++)
+    {
+        weights[r] = r % 2 == 0 ? 2.0 : 1.0;
+    }
+
+    const char *names[] = {"block", "cyclic", "block-cyclic", "weighted"};
+    Partition<Item> block(numItems, MPI_LONG_LONG, MPI_COMM_WORLD);
+    std::vector<Item> blockItems(block.getCount());
+    block.forEachOwned([&](long long global, long long local) { blockItems[local] = 3 * global + 1; });
+
+    for (int layout = Partition<Item>::BLOCK; layout <= Partition<Item>::WEIGHTED; layout++)
+    {
+        Partition<Item> part = layout == Partition<Item>::WEIGHTED
+                               ? Partition<Item>(numItems, MPI_LONG_LONG, MPI_COMM_WORLD, weights)
+                               : Partition<Item>(numItems, MPI_LONG_LONG, MPI_COMM_WORLD,
+                                                 (Partition<Item>::Layout) layout, blockSize);
+        double startTime = MPI_Wtime();
+
+        // scatter, overlapped with setting up the table the loop uses
+        std::vector<Item> mine;
+        PartitionRequest pending = part.iscatter(all.data(), mine, 0);
+        std::vector<Item> twice(16);
+        for (int k = 0; k < 16; k++)
+        {
+            twice[k] = 2 * k;
+        }
+        pending.wait();
+
+        part.forEachOwned([&](long long global, long long local) {
+            if (mine[local] != 3 * global + 1 || part.getOwner(global) != id ||
+                part.toLocal(global) != local || part.toGlobal(id, local) != global)
+            {
+                wrong = 1;
+            }
+            mine[local] = 2 * mine[local] + twice[0];
+        });
+        part.gather(mine, result.data(), 0);
+        double seconds = MPI_Wtime() - startTime;
+        if (id == 0)
+        {
+            for (long long i = 0; i < numItems; i++)
+            {
+                if (result[i] != 2 * (3 * i + 1))
+                {
+                    wrong = 1;
+                }
+            }
+        }
+
+        // and from block to this layout and back
+        std::vector<Item> moved, back;
+        block.redistribute(blockItems, part, moved);
+        part.forEachOwned([&](long long global, long long local) {
+            if (moved[local] != 3 * global + 1)
+            {
+                wrong = 1;
+            }
+        });
+        part.redistribute(moved, block, back);
+        if (back != blockItems)
+        {
+            wrong = 1;
+        }
+
+        long long fewest = part.getCount(), most = part.getCount();
+        MPI_Allreduce(MPI_IN_PLACE, &fewest, 1, MPI_LONG_LONG, MPI_MIN, MPI_COMM_WORLD);
+        MPI_Allreduce(MPI_IN_PLACE, &most, 1, MPI_LONG_LONG, MPI_MAX, MPI_COMM_WORLD);
+        MPI_Allreduce(MPI_IN_PLACE, &wrong, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+        if (id == 0)
+        {
+            printf("%-13s %lld items over %d processes, %lld to %lld each, "
+                   "%zu ranges on process 0; scatter+gather %f secs: %s\n",
+                   names[layout], numItems, numProcs, fewest, most, part.getRanges().size(),
+                   seconds, wrong ? "WRONG" : "ok");
+        }
+    }
+
+    MPI_Finalize();
+    return wrong;
+}
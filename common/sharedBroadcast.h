@@ -0,0 +1,116 @@
+/* sharedBroadcast.h broadcasts read-only data (lookup tables, parameter
+ *  arrays) into one copy per node instead of one per process.
+ *
+ * The first process of each node allocates the data's room in an MPI
+ *  shared-memory window (MPI_Win_allocate_shared() on the node
+ *  communicator of topology.h); the others map that same memory
+ *  (MPI_Win_shared_query()) and read it in place. Only the first
+ *  processes take part in the MPI_Bcast() among nodes, and root's data
+ *  reaches its own node's copy by a memcpy() (or one message, if root is
+ *  not its node's first process). So 16 processes on a node hold one
+ *  copy, not 16, and the network carries the data once per node.
+ *
+ * The copy is for reading: a process that writes to it changes it for its
+ *  whole node.
+ *
+ * Usage: #include "../common/sharedBroadcast.h"    (C or C++)
+ *        sharedBuffer table;
+ *        sharedBroadcast(id == 0 ? data : NULL, bytes, 0, MPI_COMM_WORLD, &table);
+ *        ... read ((const double *) table.data)[i] ...
+ *        freeSharedBuffer(&table);
+ */
+
+#ifndef SHARED_BROADCAST
+#define SHARED_BROADCAST
+
+#include <string.h>    // memcpy()
+#include <mpi.h>       // MPI functions
+#include "topology.h"  // getTopology(), findRoot()
+
+#define SHARED_BCAST_BYTES (1 << 30)   // the longest single MPI_Bcast(); int counts
+#define SHARED_BCAST_TAG   7375
+
+typedef struct {
+    MPI_Win window;         // the node's shared window
+    const void *data;       // this process's view of the node's copy
+    MPI_Aint bytes;
+} sharedBuffer;
+
+/* sharedBroadcast() gives every process of comm a view of root's data, in
+ *  a copy shared with the other processes of its node.
+ * parameters: data, the data (root's only; ignored elsewhere);
+ *             bytes, its length, the same on every process;
+ *             shared, for the window and the view, for freeSharedBuffer().
+ * Precondition: every process of comm calls this.
+ * return: MPI_SUCCESS, or the error of the window's allocation.
+ */
+static inline int sharedBroadcast(const void *data, MPI_Aint bytes, int root, MPI_Comm comm,
+                                  sharedBuffer *shared) {
+    const topology *where = getTopology(comm);
+    int rank, rootAt[2], displacement, error;
+    MPI_Aint offset, size;
+    char *copy;
+
+    MPI_Comm_rank(comm, &rank);
+    findRoot(comm, root, rootAt);
+    error = MPI_Win_allocate_shared(where->nodeRank == 0 ? bytes : 0, 1, MPI_INFO_NULL,
+                                    where->node, &copy, &shared->window);
+    if (error != MPI_SUCCESS) {
+        return error;
+    }
+    if (where->nodeRank != 0) {
+        MPI_Win_shared_query(shared->window, 0, &size, &displacement, &copy);
+    }
+    shared->data = copy;
+    shared->bytes = bytes;
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, shared->window);
+
+    // root's data into its node's copy
+    if (where->nodeId == rootAt[0]) {
+        if (rank == root) {
+            if (rootAt[1] == 0) {
+                memcpy(copy, data, bytes);
+            } else {
+                for (offset = 0; offset < bytes; offset += SHARED_BCAST_BYTES) {
+                    MPI_Send((char *) data + offset, (int) (bytes - offset < SHARED_BCAST_BYTES
+                             ? bytes - offset : SHARED_BCAST_BYTES), MPI_BYTE, 0,
+                             SHARED_BCAST_TAG, where->node);
+                }
+            }
+        } else if (where->nodeRank == 0) {
+            for (offset = 0; offset < bytes; offset += SHARED_BCAST_BYTES) {
+                MPI_Recv(copy + offset, (int) (bytes - offset < SHARED_BCAST_BYTES
+                         ? bytes - offset : SHARED_BCAST_BYTES), MPI_BYTE, rootAt[1],
+                         SHARED_BCAST_TAG, where->node, MPI_STATUS_IGNORE);
+            }
+        }
+    }
+
+    // and from there to the other nodes' copies
+    if (where->leaders != MPI_COMM_NULL && where->numNodes > 1) {
+        for (offset = 0; offset < bytes; offset += SHARED_BCAST_BYTES) {
+            MPI_Bcast(copy + offset, (int) (bytes - offset < SHARED_BCAST_BYTES
+                      ? bytes - offset : SHARED_BCAST_BYTES), MPI_BYTE, rootAt[0],
+                      where->leaders);
+        }
+    }
+
+    // the leaders' stores, before anyone's loads
+    MPI_Win_sync(shared->window);
+    MPI_Barrier(where->node);
+    MPI_Win_sync(shared->window);
+    return MPI_SUCCESS;
+}
+
+/* freeSharedBuffer() frees a node's copy.
+ * Precondition: every process of the communicator it was broadcast on
+ *  calls this, done reading it.
+ */
+static inline void freeSharedBuffer(sharedBuffer *shared) {
+    MPI_Win_unlock_all(shared->window);
+    MPI_Win_free(&shared->window);
+    shared->data = NULL;
+    shared->bytes = 0;
+}
+
+#endif
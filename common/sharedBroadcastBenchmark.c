@@ -0,0 +1,176 @@
+/* sharedBroadcastBenchmark.c
+ *
+ * Compares handing every process a read-only table by MPI_Bcast() into a
+ * copy of its own with sharedBroadcast() into one copy per node, for tables
+ * of 1 KiB, 4 KiB, 16 KiB, ...: the time to hand it out (allocation
+ * included, as a program pays it), the time for every process to then read
+ * it all once, and the memory the copies take on the fullest node.
+ * Every process checks its view of the table against the original first.
+ *
+ * Usage: mpirun -np N ./sharedBroadcastBenchmark [-n maxBytes]
+ *   -n  the largest table (default 64 MiB, at most 1 GiB)
+ */
+
+#include <stdio.h>     // printf()
+#include <stdlib.h>    // malloc(), atol()
+#include <string.h>    // strcmp()
+#include <mpi.h>       // MPI functions
+#include "sharedBroadcast.h" // sharedBroadcast(), getTopology()
+
+#define MIN_BYTES   (1L << 10)
+#define MAX_BYTES   (1L << 26)
+#define REPETITIONS 5            // of each, for the fastest
+
+/* fill() fills table with a pattern that check() can recognize.
+ */
+void fill(unsigned long long *table, long words) {
+    long i;
+
+    for (i = 0; i < words; i++) {
+        table[i] = i * 2654435761ULL + 17;
+    }
+}
+
+/* check() tells whether table holds fill()'s pattern.
+ */
+int check(const unsigned long long *table, long words) {
+    long i;
+
+    for (i = 0; i < words; i++) {
+        if (table[i] != i * 2654435761ULL + 17) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* readAll() reads every word of table, as a lookup-heavy program would.
+ * return: their exclusive or, so the reads cannot be left out.
+ */
+unsigned long long readAll(const unsigned long long *table, long words) {
+    unsigned long long sum = 0;
+    long i;
+
+    for (i = 0; i < words; i++) {
+        sum ^= table[i];
+    }
+    return sum;
+}
+
+/* slowest() is, on process 0, the largest of the processes' seconds.
+ */
+double slowest(double seconds) {
+    double most = 0.0;
+
+    MPI_Reduce(&seconds, &most, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    return most;
+}
+
+int main(int argc, char *argv[]) {
+    int id, numProcesses, i, r, wrong = 0, ok, fullest = 0;
+    long maxBytes = MAX_BYTES, bytes, words;
+    unsigned long long *original = NULL, *copy, checksum = 0;
+    double start, bcastSecs, sharedSecs, bcastReadSecs, sharedReadSecs, t;
+    sharedBuffer shared;
+    const topology *where;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            maxBytes = atol(argv[++i]);
+        }
+    }
+    if (maxBytes < MIN_BYTES) {
+        maxBytes = MIN_BYTES;
+    } else if (maxBytes > SHARED_BCAST_BYTES) {
+        maxBytes = SHARED_BCAST_BYTES;    // MPI_Bcast()'s int count, for the comparison
+    }
+    where = getTopology(MPI_COMM_WORLD);
+    MPI_Allreduce(&where->nodeSize, &fullest, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+    if (id == 0) {
+        printf("%d processes on %d nodes, at most %d per node; "
+               "microseconds of the slowest process, fastest of %d\n",
+               numProcesses, where->numNodes, fullest, REPETITIONS);
+        printf("%12s %12s %12s %12s %12s %14s %14s\n", "bytes", "MPI_Bcast", "shared",
+               "read own", "read shared", "node MiB own", "node MiB shared");
+    }
+
+    for (bytes = MIN_BYTES; bytes <= maxBytes; bytes *= 4) {
+        words = bytes / sizeof(unsigned long long);
+        if (id == 0) {
+            original = (unsigned long long *) malloc(bytes);
+            if (original == NULL) {
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            fill(original, words);
+        }
+
+        // check first
+        copy = (unsigned long long *) malloc(bytes);
+        if (copy == NULL) {
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        if (id == 0) {
+            memcpy(copy, original, bytes);
+        }
+        MPI_Bcast(copy, (int) bytes, MPI_BYTE, 0, MPI_COMM_WORLD);
+        sharedBroadcast(original, bytes, 0, MPI_COMM_WORLD, &shared);
+        ok = check(copy, words) && check((const unsigned long long *) shared.data, words);
+        if (!ok) {
+            fprintf(stderr, "process %d: wrong table of %ld bytes\n", id, bytes);
+            wrong = 1;
+        }
+        free(copy);
+        freeSharedBuffer(&shared);
+
+        bcastSecs = sharedSecs = bcastReadSecs = sharedReadSecs = 1e30;
+        for (r = 0; r < REPETITIONS; r++) {
+            MPI_Barrier(MPI_COMM_WORLD);
+            start = MPI_Wtime();
+            copy = (unsigned long long *) malloc(bytes);
+            if (id == 0) {
+                memcpy(copy, original, bytes);
+            }
+            MPI_Bcast(copy, (int) bytes, MPI_BYTE, 0, MPI_COMM_WORLD);
+            t = slowest(MPI_Wtime() - start);
+            bcastSecs = t < bcastSecs ? t : bcastSecs;
+
+            MPI_Barrier(MPI_COMM_WORLD);
+            start = MPI_Wtime();
+            checksum ^= readAll(copy, words);
+            t = slowest(MPI_Wtime() - start);
+            bcastReadSecs = t < bcastReadSecs ? t : bcastReadSecs;
+            free(copy);
+
+            MPI_Barrier(MPI_COMM_WORLD);
+            start = MPI_Wtime();
+            sharedBroadcast(original, bytes, 0, MPI_COMM_WORLD, &shared);
+            t = slowest(MPI_Wtime() - start);
+            sharedSecs = t < sharedSecs ? t : sharedSecs;
+
+            MPI_Barrier(MPI_COMM_WORLD);
+            start = MPI_Wtime();
+            checksum ^= readAll((const unsigned long long *) shared.data, words);
+            t = slowest(MPI_Wtime() - start);
+            sharedReadSecs = t < sharedReadSecs ? t : sharedReadSecs;
+            freeSharedBuffer(&shared);
+        }
+
+        if (id == 0) {
+            printf("%12ld %12.1f %12.1f %12.1f %12.1f %14.2f %14.2f\n", bytes, bcastSecs * 1e6,
+                   sharedSecs * 1e6, bcastReadSecs * 1e6, sharedReadSecs * 1e6,
+                   (double) fullest * bytes / (1 << 20), (double) bytes / (1 << 20));
+            fflush(stdout);
+            free(original);
+        }
+    }
+
+    if (checksum == 1) {    // never, but the reads have to count for something
+        printf("%llu\n", checksum);
+    }
+    MPI_Finalize();
+    return wrong;
+}
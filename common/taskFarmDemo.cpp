@@ -0,0 +1,134 @@
+/* taskFarmDemo.cpp shows TaskFarm.h at work, and checks it: it farms
+ *  out the tiles of a Mandelbrot image (proj05's, without the drawing),
+ *  one tile per task, whose cost varies a lot from the set's inside to
+ *  its outside. Process 0 then computes the image itself and compares
+ *  every tile's result with the farm's, and the times.
+ *
+ * Usage: mpirun -np N ./taskFarmDemo [-w width(1200)] [-h height(800)]
+ *                                    [-t tileSize(20)] [-k prefetch(2)]
+ *                                    [-g groupSize(0)] [-v]
+ *   -g  processes per sub-master's group (0: one master for all)
+ *   -v  print every process's share
+ */
+
+#include <stdio.h>      // printf()
+#include <stdlib.h>     // atoi()
+#include <string.h>     // strcmp()
+#include <complex>      // complex<T>
+#include <vector>       // C++ vector
+#include <mpi.h>        // MPI library
+#include "TaskFarm.h"   // TaskFarm
+
+const int THRESHOLD = 500;  // our Mandelbrot 'escape' threshold
+
+struct Tile {
+    int row, col;           // of its top-left pixel
+};
+
+struct TileResult {
+    long long iterations;   // of all its pixels
+    int inside;             // its pixels in the set
+};
+
+/* the Mandelbrot calculation of proj05, for the point (x,y)
+ * @return: the iterations (x,y) takes to escape; THRESHOLD if it does not.
+ */
+int doMandelbrotCalc(long double x, long double y)
+{
+    std::complex<long double> originalComplex(x, y);
+    std::complex<long double> comp(x, y);
+    int count = 0;
+    while (std::abs(comp) < 2.0 && count < THRESHOLD)
+    {
+        comp = comp * comp + originalComplex;
+        ++count;
+    }
+    return count;
+}
+
+int main(int argc, char *argv[])
+{
+    int id, numProcs, width = 1200, height = 800, tileSize = 20, prefetch = 2, groupSize = 0;
+    bool everyProcess = false;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &numProcs);
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+            width = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-h") == 0 && i + 1 < argc)
+            height = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            tileSize = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc)
+            prefetch = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc)
+            groupSize = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-v") == 0)
+            everyProcess = true;
+    }
+    if (tileSize < 1)
+        tileSize = 1;
+
+    // the plane from -2-1.125i to 1+1.125i, as proj05's canvas
+    const long double startX = -2.0, startY = -1.125;
+    const long double deltaX = 3.0L / width, deltaY = 2.25L / height;
+    auto computeTile = [=](const Tile &tile) {
+        TileResult result = {0, 0};
+        for (int row = tile.row; row < tile.row + tileSize && row < height; row++)
+        {
+            for (int col = tile.col; col < tile.col + tileSize && col < width; col++)
+            {
+                int reps = doMandelbrotCalc(startX + col * deltaX, startY + row * deltaY);
+                result.iterations += reps;
+                result.inside += reps >= THRESHOLD;
+            }
+        }
+        return result;
+    };
+
+    std::vector<Tile> tiles;
+    std::vector<TileResult> results;
+    if (id == 0)
+    {
+        for (int row = 0; row < height; row += tileSize)
+        {
+            for (int col = 0; col < width; col += tileSize)
+            {
+                Tile tile = {row, col};
+                tiles.push_back(tile);
+            }
+        }
+    }
+
+    TaskFarm<Tile, TileResult> farm(MPI_COMM_WORLD, prefetch, groupSize);
+    MPI_Barrier(MPI_COMM_WORLD);
+    double farmTime = MPI_Wtime();
+    farm.run(tiles, results, computeTile);
+    farmTime = MPI_Wtime() - farmTime;
+
+    int wrong = 0;
+    if (id == 0)
+    {
+        double sequentialTime = MPI_Wtime();
+        long long inside = 0;
+        for (size_t i = 0; i < tiles.size(); i++)
+        {
+            TileResult expected = computeTile(tiles[i]);
+            if (expected.iterations != results[i].iterations || expected.inside != results[i].inside)
+                wrong = 1;
+            inside += results[i].inside;
+        }
+        sequentialTime = MPI_Wtime() - sequentialTime;
+
+        printf("%d x %d image, %zu tiles of %d x %d, %lld pixels in the set: %s\n", width, height,
+               tiles.size(), tileSize, tileSize, inside, wrong ? "WRONG" : "ok");
+        farm.report("Mandelbrot tiles", everyProcess);
+        printf("farm %f s, process 0 alone %f s: speedup %.2f\n", farmTime, sequentialTime,
+               farmTime > 0.0 ? sequentialTime / farmTime : 0.0);
+    }
+
+    MPI_Finalize();
+    return wrong;
+}
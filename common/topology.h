@@ -0,0 +1,193 @@
+/* topology.h tells a process where it runs: which node of the hosts file
+ *  (mpirun's -hostfile, as genHosts.pl writes it), which process of that
+ *  node, and which socket of it. It gives the communicators to match, so a
+ *  program can work within a node through shared memory first and send
+ *  only one process's share per node over the network:
+ *
+ *  - node: the processes of comm that share this one's memory
+ *     (MPI_Comm_split_type(MPI_COMM_TYPE_SHARED)), ranked as in comm;
+ *  - leaders: the first process of each node (MPI_COMM_NULL on the
+ *     others), ranked as in comm, so leader i is on node i.
+ *
+ * The topology of a communicator is made on the first getTopology() of it
+ *  (a collective call) and cached on it as an attribute, so later calls are
+ *  free; it is freed with the communicator (at MPI_Finalize() for
+ *  MPI_COMM_WORLD).
+ *
+ * Usage: #include "../common/topology.h"    (C or C++)
+ *        const topology *where = getTopology(MPI_COMM_WORLD);
+ *        MPI_Reduce(..., 0, where->node);
+ *        if (where->leaders != MPI_COMM_NULL) MPI_Reduce(..., 0, where->leaders);
+ */
+
+#ifndef TOPOLOGY
+#define TOPOLOGY
+
+#include <stdio.h>     // printf(), fopen()
+#include <stdlib.h>    // malloc()
+#include <string.h>    // strchr(), strrchr()
+#include <mpi.h>       // MPI functions
+
+typedef struct {
+    MPI_Comm node;          // the processes of comm on this node
+    MPI_Comm leaders;       // the first process of each node (else MPI_COMM_NULL)
+    int nodeRank, nodeSize; // this process in node, and its processes
+    int nodeId, numNodes;   // this node (its leader's rank in leaders), and the nodes
+    int cpu;                // the CPU this process was on when asked; -1 if unknown
+    int socket, numSockets; // that CPU's socket, and the sockets of the node's
+                            //  processes (max + 1); -1 and 0 if unknown
+    char hostName[MPI_MAX_PROCESSOR_NAME];
+} topology;
+
+static int topologyKey = MPI_KEYVAL_INVALID;
+
+static inline int freeTopology(MPI_Comm comm, int key, void *value, void *extraState) {
+    topology *where = (topology *) value;
+
+    MPI_Comm_free(&where->node);
+    if (where->leaders != MPI_COMM_NULL) {
+        MPI_Comm_free(&where->leaders);
+    }
+    free(where);
+    return MPI_SUCCESS;
+}
+
+/* currentCpu() reads the CPU this process last ran on (field 39 of
+ *  /proc/self/stat), without needing _GNU_SOURCE for sched_getcpu().
+ * return: the CPU; -1 where there is no /proc.
+ */
+static inline int currentCpu(void) {
+    char line[1024], *field;
+    int cpu = -1, i;
+    FILE *stat = fopen("/proc/self/stat", "r");
+
+    if (stat == NULL) {
+        return -1;
+    }
+    if (fgets(line, sizeof(line), stat) != NULL && (field = strrchr(line, ')')) != NULL) {
+        // after the command name, in parentheses, comes field 3
+        for (i = 3; i <= 39 && field != NULL; i++) {
+            field = strchr(field + 1, ' ');
+        }
+        if (field != NULL) {
+            cpu = atoi(field + 1);
+        }
+    }
+    fclose(stat);
+    return cpu;
+}
+
+/* socketOf() reads the socket (physical package) of cpu from sysfs.
+ * return: the socket; -1 if unknown.
+ */
+static inline int socketOf(int cpu) {
+    char path[128];
+    int socket = -1;
+    FILE *package;
+
+    if (cpu < 0) {
+        return -1;
+    }
+    sprintf(path, "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+    package = fopen(path, "r");
+    if (package != NULL) {
+        if (fscanf(package, "%d", &socket) != 1) {
+            socket = -1;
+        }
+        fclose(package);
+    }
+    return socket;
+}
+
+/* getTopology() finds, or makes, the topology of comm.
+ * Precondition: every process of comm calls this (the first time, at least).
+ * return: the topology, owned by comm; do not free it.
+ */
+static inline const topology *getTopology(MPI_Comm comm) {
+    topology *where;
+    int found = 0, rank, length;
+    int node[2] = {0, 0};    // nodeId, numNodes
+
+    if (topologyKey == MPI_KEYVAL_INVALID) {
+        MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, freeTopology, &topologyKey, NULL);
+    }
+    MPI_Comm_get_attr(comm, topologyKey, &where, &found);
+    if (found) {
+        return where;
+    }
+
+    where = (topology *) malloc(sizeof(topology));
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &where->node);
+    MPI_Comm_rank(where->node, &where->nodeRank);
+    MPI_Comm_size(where->node, &where->nodeSize);
+    MPI_Comm_split(comm, where->nodeRank == 0 ? 0 : MPI_UNDEFINED, rank, &where->leaders);
+
+    // the leaders know their node's number and the count; tell the rest of each node
+    if (where->leaders != MPI_COMM_NULL) {
+        MPI_Comm_rank(where->leaders, &node[0]);
+        MPI_Comm_size(where->leaders, &node[1]);
+    }
+    MPI_Bcast(node, 2, MPI_INT, 0, where->node);
+    where->nodeId = node[0];
+    where->numNodes = node[1];
+
+    where->cpu = currentCpu();
+    where->socket = socketOf(where->cpu);
+    MPI_Allreduce(&where->socket, &where->numSockets, 1, MPI_INT, MPI_MAX, where->node);
+    where->numSockets++;
+    MPI_Get_processor_name(where->hostName, &length);
+
+    MPI_Comm_set_attr(comm, topologyKey, where);
+    return where;
+}
+
+/* findRoot() finds the node of root, a process of comm, and its rank there.
+ * Precondition: every process of comm calls this, with the same root.
+ * parameters: rootAt, for root's nodeId and nodeRank.
+ */
+static inline void findRoot(MPI_Comm comm, int root, int rootAt[2]) {
+    const topology *where = getTopology(comm);
+
+    rootAt[0] = rootAt[1] = 0;    // process 0 is always the first of node 0
+    if (root != 0) {
+        rootAt[0] = where->nodeId;
+        rootAt[1] = where->nodeRank;
+        MPI_Bcast(rootAt, 2, MPI_INT, root, comm);
+    }
+}
+
+/* printTopology() prints, on process 0 of comm, one line per process:
+ *  its rank, host, node, rank in the node, and CPU and socket.
+ * Precondition: every process of comm calls this.
+ */
+static inline void printTopology(MPI_Comm comm) {
+    const topology *where = getTopology(comm);
+    int rank, size, r;
+    int mine[5] = {where->nodeId, where->nodeRank, where->nodeSize, where->cpu, where->socket};
+    int *all = NULL;
+    char *names = NULL;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    if (rank == 0) {
+        all = (int *) malloc(5 * size * sizeof(int));
+        names = (char *) malloc((size_t) size * MPI_MAX_PROCESSOR_NAME);
+    }
+    MPI_Gather(mine, 5, MPI_INT, all, 5, MPI_INT, 0, comm);
+    MPI_Gather(where->hostName, MPI_MAX_PROCESSOR_NAME, MPI_CHAR,
+               names, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, 0, comm);
+    if (rank == 0) {
+        printf("%d processes on %d nodes\n", size, where->numNodes);
+        for (r = 0; r < size; r++) {
+            printf("  process %3d on %-20s node %3d, %3d of %3d, cpu %3d, socket %2d\n", r,
+                   names + (size_t) r * MPI_MAX_PROCESSOR_NAME, all[5 * r], all[5 * r + 1],
+                   all[5 * r + 2], all[5 * r + 3], all[5 * r + 4]);
+        }
+        fflush(stdout);
+        free(all);
+        free(names);
+    }
+}
+
+#endif
@@ -1,5 +1,5 @@
 /* arrayPassing.c
- * ... illustrates using MPI_Send() and MPI_Recv() commands on arrays...
+ * ... illustrates using the MPI_Sendrecv() command on arrays...
  *
  * Joel Adams, Calvin College, September 2013.
  *
@@ -22,7 +22,7 @@ int odd(int number) { return number % 2; }
 int main(int argc, char** argv) {
     const int SIZE = (MPI_MAX_PROCESSOR_NAME+32) * sizeof(char);
     const int MASTER = 0;
-    int id = -1, numProcesses = -1, length = -1; 
+    int id = -1, numProcesses = -1, length = -1, partner = -1; 
     char * sendString = NULL;
     char * receivedString = NULL;
     char hostName[MPI_MAX_PROCESSOR_NAME];
@@ -49,17 +49,12 @@ int main(int argc, char** argv) {
 
     sprintf(sendString, "\n\tProcess %d is on host '%s'\n", id, hostName);
 
-    if ( odd(id) ) {  // odd processes send, then receive 
-        MPI_Send(sendString, strlen(sendString)+1,
-                       MPI_CHAR, id-1, 1, MPI_COMM_WORLD);
-        MPI_Recv(receivedString, SIZE, MPI_CHAR, id-1, 2, 
-                       MPI_COMM_WORLD, &status);
-    } else {          // even processes receive, then send 
-        MPI_Recv(receivedString, SIZE, MPI_CHAR, id+1, 1, 
-                       MPI_COMM_WORLD, &status);
-        MPI_Send(sendString, strlen(sendString)+1,
-                       MPI_CHAR, id+1, 2, MPI_COMM_WORLD);
-    }
+    // each process swaps with its partner (odd with the even one below it);
+    //  MPI_Sendrecv() does both at once, so neither has to go first
+    partner = odd(id) ? id-1 : id+1;
+    MPI_Sendrecv(sendString, strlen(sendString)+1, MPI_CHAR, partner, 1,
+                 receivedString, SIZE, MPI_CHAR, partner, 1,
+                 MPI_COMM_WORLD, &status);
 
     printf("Process %d of %d received the message:%s\n",
                 id, numProcesses, receivedString);
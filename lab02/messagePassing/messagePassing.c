@@ -1,5 +1,5 @@
 /* messagePassing.c
- * ... illustrates the use of the MPI_Send() and MPI_Recv() commands...
+ * ... illustrates the use of the MPI_Sendrecv() command...
  *
  * Joel Adams, Calvin University, CS 374, November 2009.
  *
@@ -21,7 +21,7 @@ int odd(int number) { return number % 2; }
 
 int main(int argc, char** argv) {
     const int MASTER = 0;
-    int id = -1, numProcesses = -1; 
+    int id = -1, numProcesses = -1, partner = -1; 
     float sendValue = -1, receivedValue = -1;
     MPI_Status status;
 
@@ -39,15 +39,12 @@ int main(int argc, char** argv) {
     }
 
     sendValue = sqrt(id);
-    if ( odd(id) ) {  // odd processors send, then receive 
-        MPI_Send(&sendValue, 1, MPI_FLOAT, id-1, 1, MPI_COMM_WORLD);
-        MPI_Recv(&receivedValue, 1, MPI_FLOAT, id-1, 2, 
-                       MPI_COMM_WORLD, &status);
-    } else {          // even processors receive, then send 
-        MPI_Recv(&receivedValue, 1, MPI_FLOAT, id+1, 1, 
-                       MPI_COMM_WORLD, &status);
-        MPI_Send(&sendValue, 1, MPI_FLOAT, id+1, 2, MPI_COMM_WORLD);
-    }
+    // each process swaps with its partner (odd with the even one below it);
+    //  MPI_Sendrecv() does both at once, so neither has to go first
+    partner = odd(id) ? id-1 : id+1;
+    MPI_Sendrecv(&sendValue, 1, MPI_FLOAT, partner, 1,
+                 &receivedValue, 1, MPI_FLOAT, partner, 1,
+                 MPI_COMM_WORLD, &status);
 
     printf("Process %d of %d computed %f and received %f\n",
                 id, numProcesses, sendValue, receivedValue);
@@ -0,0 +1,69 @@
+/* checkBlocks.h checks runs of blocks of 64 inputs of the circuit
+ *  (checkCircuitBits.h), split among a process's OpenMP threads, and
+ *  collects the solutions they find (solutionBuffer.h).
+ *
+ * The threads append to the one buffer of the process, one at a time
+ *  (the "solutions" critical section); they rarely need to, since few
+ *  blocks hold a solution.
+ *
+ * Usage: #include "checkBlocks.h"
+ *        count += checkBlocks(first, last, &solutions);
+ *        count += checkBlocksUntil(first, last, &solutions, &early, &checked);
+ */
+
+#ifndef CHECK_BLOCKS
+#define CHECK_BLOCKS
+
+#include "checkCircuitBits.h" // evaluateCircuitBits()
+#include "solutionBuffer.h" // appendSolutionLanes()
+#include "earlyStop.h" // pollEarlyStop(), STOP_POLL_BLOCKS
+
+/* checkBlock() checks the block of 64 inputs i; safe to call from any thread.
+ * return: the number of solutions, which are added to solutions.
+ */
+static inline int checkBlock(unsigned long i, solutionBuffer *solutions) {
+    circuitLanes found = evaluateCircuitBits(i * CIRCUIT_LANES);
+
+    if (found) {
+        #pragma omp critical (solutions)
+        appendSolutionLanes(solutions, i * CIRCUIT_LANES, found);
+    }
+    return __builtin_popcountll(found);
+}
+
+/* checkBlocks() checks the blocks of 64 inputs first .. last-1,
+ *  split among this process's threads.
+ * return: the number of solutions, which are added to solutions.
+ */
+static inline int checkBlocks(unsigned long first, unsigned long last,
+                              solutionBuffer *solutions) {
+    int count = 0;
+
+    #pragma omp parallel for reduction(+:count) schedule(static)
+    for (unsigned long i = first; i < last; i++) {
+        count += checkBlock(i, solutions);
+    }
+    return count;
+}
+
+/* checkBlocksUntil() checks the blocks first .. last-1 as checkBlocks()
+ *  does, but STOP_POLL_BLOCKS at a time, giving up once early is done.
+ * return: the number of solutions; checked grows by the blocks checked.
+ */
+static inline int checkBlocksUntil(unsigned long first, unsigned long last,
+                                   solutionBuffer *solutions, earlyStop *early,
+                                   unsigned long *checked) {
+    int count = 0, found;
+    unsigned long next;
+
+    for (; first < last && !early->done; first = next) {
+        next = last - first > STOP_POLL_BLOCKS ? first + STOP_POLL_BLOCKS : last;
+        found = checkBlocks(first, next, solutions);
+        count += found;
+        *checked += next - first;
+        pollEarlyStop(early, found);
+    }
+    return count;
+}
+
+#endif
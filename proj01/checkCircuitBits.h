@@ -0,0 +1,105 @@
+/* checkCircuitBits.h defines a bit-sliced checkCircuit(), which checks
+ *  64 inputs of the circuit at once, without a branch per clause.
+ *
+ * The inputs base .. base+63 (base a multiple of 64) differ only in
+ *  their low 6 bits, so lane k of each 64-bit word stands for input base+k:
+ *  - v[0..5] are fixed patterns in which lane k holds bit i of k,
+ *  - v[6..31] are all ones or all zeros, copied from the bits of base.
+ * Each || of the circuit becomes |, each && becomes & and each ! becomes ~,
+ *  so the result has a 1 in exactly the lanes whose input satisfies the
+ *  circuit, and a popcount of it counts the solutions.
+ *
+ * Usage: for (block = first; block < last; block++)
+ *            count += checkCircuitBits(id, block * CIRCUIT_LANES);
+ */
+
+#ifndef CHECK_CIRCUIT_BITS
+#define CHECK_CIRCUIT_BITS
+
+#include <stdio.h>     // printf()
+#include <stdint.h>    // uint64_t
+
+#define CIRCUIT_INPUTS 32                         // bits in one input
+#define CIRCUIT_LANES  64                         // inputs checked at once
+#define CIRCUIT_BLOCKS (1UL << (CIRCUIT_INPUTS - 6)) // 2^32 inputs / 64 lanes
+
+typedef uint64_t circuitLanes;
+
+// lane k of lanePattern[i] is bit i of k
+static const circuitLanes lanePattern[6] = {
+    0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+};
+
+/* evaluateCircuitBits() evaluates the circuit for 64 inputs.
+ * parameters: base, the first of the inputs (a multiple of 64).
+ *
+ * return: a word with bit k set iff input base+k satisfies the circuit.
+ */
+static inline circuitLanes evaluateCircuitBits(unsigned long base) {
+    circuitLanes v[CIRCUIT_INPUTS];
+    int i;
+
+    for (i = 0; i < 6; i++) {
+        v[i] = lanePattern[i];
+    }
+    for (i = 6; i < CIRCUIT_INPUTS; i++) {
+        v[i] = ((base >> i) & 1) ? ~(circuitLanes)0 : 0;
+    }
+
+    return ( (v[0] | v[1]) & (~v[1] | ~v[3]) & (v[2] | v[3])
+           & (~v[3] | ~v[4]) & (v[4] | ~v[5])
+           & (v[5] | ~v[6]) & (v[5] | v[6])
+           & (v[6] | ~v[15]) & (v[7] | ~v[8])
+           & (~v[7] | ~v[13]) & (v[8] | v[9])
+           & (v[8] | ~v[9]) & (~v[9] | ~v[10])
+           & (v[9] | v[11]) & (v[10] | v[11])
+           & (v[12] | v[13]) & (v[13] | ~v[14])
+           & (v[14] | v[15]) )
+           &
+           ( (v[16] | v[17]) & (~v[17] | ~v[19]) & (v[18] | v[19])
+           & (~v[19] | ~v[20]) & (v[20] | ~v[21])
+           & (v[21] | ~v[22]) & (v[21] | v[22])
+           & (v[22] | ~v[31]) & (v[23] | ~v[24])
+           & (~v[23] | ~v[29]) & (v[24] | v[25])
+           & (v[24] | ~v[25]) & (~v[25] | ~v[26])
+           & (v[25] | v[27]) & (v[26] | v[27])
+           & (v[28] | v[29]) & (v[29] | ~v[30])
+           & (v[30] | v[31]) );
+}
+
+/* printCircuitInput() prints a satisfying input, as checkCircuit() did.
+ * parameters: id, the id of the process checking;
+ *             input, the input (its 32 bits, most significant first).
+ */
+static inline void printCircuitInput(int id, unsigned long input) {
+    char digits[CIRCUIT_INPUTS + 1];
+    int i;
+
+    for (i = 0; i < CIRCUIT_INPUTS; i++) {
+        digits[i] = ((input >> (CIRCUIT_INPUTS - 1 - i)) & 1) ? '1' : '0';
+    }
+    digits[CIRCUIT_INPUTS] = '\0';
+    printf ("%d) %s \n", id, digits);
+    fflush (stdout);
+}
+
+/* checkCircuitBits() checks the circuit for 64 inputs.
+ * parameters: id, the id of the process checking;
+ *             base, the first of the inputs (a multiple of 64).
+ *
+ * output: the binary rep. of each input for which the circuit outputs 1
+ * return: the number of those inputs.
+ */
+static inline int checkCircuitBits(int id, unsigned long base) {
+    circuitLanes solutions = evaluateCircuitBits(base);
+    int count = __builtin_popcountll(solutions);
+
+    while (solutions) {
+        printCircuitInput(id, base + __builtin_ctzll(solutions));
+        solutions &= solutions - 1;    // clear the lowest solution
+    }
+    return count;
+}
+
+#endif
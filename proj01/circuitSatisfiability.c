@@ -2,7 +2,8 @@
  *  Problem using a brute-force sequential solution.
  *
  *   The particular circuit being tested is "wired" into the
- *   logic of function 'checkCircuit'. All combinations of
+ *   logic of function 'evaluateCircuitBits' (checkCircuitBits.h),
+ *   which checks 64 inputs at a time. All combinations of
  *   inputs that satisfy the circuit are printed.
  *
  *   16-bit version by Michael J. Quinn, Oregon State University, Sept 2002.
@@ -16,13 +17,11 @@
  */
 
 #include <stdio.h>     // printf()
-#include <limits.h>    // UINT_MAX
 #include <mpi.h>       // MPI functions
-
-int checkCircuit (int, long);
+#include "checkCircuitBits.h" // checkCircuitBits()
 
 int main (int argc, char *argv[]) {
-   long i;               // loop variable (64 bits) 
+   unsigned long i;      // block of 64 inputs (loop variable)
    int id = 0;           // process id 
    int count = 0;        // number of solutions 
      
@@ -32,8 +31,8 @@ int main (int argc, char *argv[]) {
 
    printf ("\nProcess %d is checking the circuit...\n", id);
 
-   for (i = 0; i <= UINT_MAX; ++i) {
-      count += checkCircuit (id, i);
+   for (i = 0; i < CIRCUIT_BLOCKS; ++i) {
+      count += checkCircuitBits (id, i * CIRCUIT_LANES);
    }
 
    totalTime = MPI_Wtime() - startTime;
@@ -43,67 +42,6 @@ int main (int argc, char *argv[]) {
    fflush (stdout);
 
    printf("Process %d finished in time %f secs.\n", id, totalTime);
-   //printf("A total of %d solutions were found.\n", globalCount);
+   printf("A total of %d solutions were found.\n", count);
    return 0;
 }
-
-/* EXTRACT_BIT is a macro that extracts the ith bit of number n.
- *
- * parameters: n, a number;
- *             i, the position of the bit we want to know.
- *
- * return: 1 if 'i'th bit of 'n' is 1; 0 otherwise 
- */
-
-#define EXTRACT_BIT(n,i) ( (n & (1<<i) ) ? 1 : 0)
-
-
-/* checkCircuit() checks the circuit for a given input.
- * parameters: id, the id of the process checking;
- *             bits, the (long) rep. of the input being checked.
- *
- * output: the binary rep. of bits if the circuit outputs 1
- * return: 1 if the circuit outputs 1; 0 otherwise.
- */
-
-#define SIZE 32
-
-int checkCircuit (int id, long bits) {
-   int v[SIZE];        /* Each element is one of the 32 bits */
-   int i;
-
-   for (i = 0; i < SIZE; i++) {
-     v[i] = EXTRACT_BIT(bits,i);
-   }
-
-   if ( ( (v[0] || v[1]) && (!v[1] || !v[3]) && (v[2] || v[3])
-       && (!v[3] || !v[4]) && (v[4] || !v[5])
-       && (v[5] || !v[6]) && (v[5] || v[6])
-       && (v[6] || !v[15]) && (v[7] || !v[8])
-       && (!v[7] || !v[13]) && (v[8] || v[9])
-       && (v[8] || !v[9]) && (!v[9] || !v[10])
-       && (v[9] || v[11]) && (v[10] || v[11])
-       && (v[12] || v[13]) && (v[13] || !v[14])
-       && (v[14] || v[15]) )
-       &&
-          ( (v[16] || v[17]) && (!v[17] || !v[19]) && (v[18] || v[19])
-       && (!v[19] || !v[20]) && (v[20] || !v[21])
-       && (v[21] || !v[22]) && (v[21] || v[22])
-       && (v[22] || !v[31]) && (v[23] || !v[24])
-       && (!v[23] || !v[29]) && (v[24] || v[25])
-       && (v[24] || !v[25]) && (!v[25] || !v[26])
-       && (v[25] || v[27]) && (v[26] || v[27])
-       && (v[28] || v[29]) && (v[29] || !v[30])
-       && (v[30] || v[31]) ) )
-   {
-      printf ("%d) %d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d \n", id,
-         v[31],v[30],v[29],v[28],v[27],v[26],v[25],v[24],v[23],v[22],
-         v[21],v[20],v[19],v[18],v[17],v[16],v[15],v[14],v[13],v[12],
-         v[11],v[10],v[9],v[8],v[7],v[6],v[5],v[4],v[3],v[2],v[1],v[0]);
-      fflush (stdout);
-      return 1;
-   } else {
-      return 0;
-   }
-}
-
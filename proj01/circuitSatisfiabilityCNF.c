@@ -0,0 +1,380 @@
+/* circuitSatisfiabilityCNF.c
+ *
+ * A generalization of circuitSatisfiabilityChunks.c: instead of the circuit
+ * wired into checkCircuitBits(), it counts the solutions of any circuit of
+ * up to 128 variables given as a DIMACS CNF file (see cnfCircuit.h), as
+ * long as none of its components has more than 64.
+ *
+ * The circuit is first split into its independent components (splitCnf()),
+ * and each is searched by brute force on its own, distributing its blocks
+ * of 64 inputs with the 'Chunks' Parallel Loop pattern; the circuit's count
+ * is the product of theirs. The built-in circuit, for instance, is two
+ * 16-variable halves, so this checks 2 x 2^16 inputs instead of 2^32.
+ *
+ * With -g, each process instead walks its chunk of a component's blocks in
+ * Gray-code order (see cnfGrayWalk), updating only the clauses of the one
+ * variable that changes from each block to the next.
+ *
+ * A search of 2^40 inputs or more takes hours to days, so with -c each
+ * process saves its progress to a checkpoint file every minute (see
+ * searchCheckpoint.h); running the same command again resumes from it.
+ *
+ * Usage: mpirun -np N ./circuitSatisfiabilityCNF [-e] [-g] [-c file] [circuit.cnf]
+ *   -e          also print every solution (the product of the components')
+ *   -g          walk the blocks of 64 inputs in Gray-code order
+ *   -c file     checkpoint to file, resuming from it if it holds this search
+ *   circuit.cnf (the default) is the circuit of circuitSatisfiability.c.
+ */
+
+#include <stdio.h>     // printf()
+#include <stdlib.h>    // realloc()
+#include <string.h>    // strcmp()
+#include <math.h>      // ldexp()
+#include <mpi.h>       // MPI functions
+#include "cnfCircuit.h" // readCnf(), checkCnfBits()
+#include "searchCheckpoint.h" // saveCheckpoint()
+#include "throughput.h" // reportThroughput()
+
+// blocks of 64 inputs between looks at the checkpoint clock (a power of 2)
+#define CHECKPOINT_POLL_BLOCKS (1ULL << 20)
+
+// Function to calculate start and stop values for each chunk
+void getChunkStartStopValues(int id, int numProcesses, unsigned long long numIterations,
+                             unsigned long long* start, unsigned long long* stop) {
+    unsigned long long chunkSize = numIterations / numProcesses;
+    unsigned long long remainder = numIterations % numProcesses;
+
+    if (id < remainder) {
+        *start = id * (chunkSize + 1);
+        *stop = *start + chunkSize + 1;
+    } else {
+        *start = id * chunkSize + remainder;
+        *stop = *start + chunkSize;
+    }
+}
+
+/* loadCircuit() reads the circuit on process 0 and sends it to the others.
+ * return: 1 on every process if the circuit was loaded; 0 on every one if not.
+ */
+int loadCircuit(int id, const char *fileName, cnfFormula *formula) {
+    int sizes[2] = {0, 0};    // numVars, numClauses (0 variables: failed)
+
+    if (id == 0 && readCnf(fileName, formula)) {
+        sizes[0] = formula->numVars;
+        sizes[1] = formula->numClauses;
+    }
+    MPI_Bcast(sizes, 2, MPI_INT, 0, MPI_COMM_WORLD);
+    if (sizes[0] == 0) {
+        return 0;
+    }
+
+    if (id != 0 && !allocateFormula(formula, sizes[0], sizes[1])) {
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    // each cnfWide mask travels as two 64-bit words
+    MPI_Bcast(formula->positive, 2 * sizes[1], MPI_UINT64_T, 0, MPI_COMM_WORLD);
+    MPI_Bcast(formula->negative, 2 * sizes[1], MPI_UINT64_T, 0, MPI_COMM_WORLD);
+    return 1;
+}
+
+/* formulaSignature() hashes a formula (FNV-1a over its clauses), so that a
+ *  checkpoint of one circuit is never resumed as another's.
+ */
+unsigned long long formulaSignature(const cnfFormula *formula) {
+    unsigned long long hash = 14695981039346656037ULL;
+    const unsigned char *bytes;
+    size_t i, size = formula->numClauses * sizeof(cnfWide);
+
+    hash = (hash ^ (unsigned long long) formula->numVars) * 1099511628211ULL;
+    for (bytes = (const unsigned char *) formula->positive, i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    for (bytes = (const unsigned char *) formula->negative, i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// the solutions one process found for one component
+typedef struct {
+    unsigned long long *values;
+    long count, capacity;
+} solutionList;
+
+void appendSolution(solutionList *list, unsigned long long value) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? 2 * list->capacity : 64;
+        list->values = (unsigned long long *) realloc(list->values,
+                                                       list->capacity * sizeof(unsigned long long));
+        if (list->values == NULL) {
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+    list->values[list->count++] = value;
+}
+
+/* gatherSolutions() collects every process's list onto process 0.
+ * Postcondition: on process 0, list holds the solutions of all processes.
+ */
+void gatherSolutions(int id, int numProcesses, solutionList *list) {
+    int *counts = NULL, *displs = NULL;
+    int count = (int) list->count, p;
+    solutionList all = {NULL, 0, 0};
+
+    if (id == 0) {
+        counts = (int *) malloc(numProcesses * sizeof(int));
+        displs = (int *) malloc(numProcesses * sizeof(int));
+    }
+    MPI_Gather(&count, 1, MPI_INT, counts, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (id == 0) {
+        for (p = 0; p < numProcesses; p++) {
+            displs[p] = (int) all.count;
+            all.count += counts[p];
+        }
+        all.capacity = all.count;
+        all.values = (unsigned long long *) malloc((all.count + 1) * sizeof(unsigned long long));
+    }
+    MPI_Gatherv(list->values, count, MPI_UNSIGNED_LONG_LONG,
+                all.values, counts, displs, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+    if (id == 0) {
+        free(list->values);
+        *list = all;
+        free(counts);
+        free(displs);
+    }
+}
+
+/* printProduct() prints every combination of one solution per component.
+ * parameters: components, the circuit's components;
+ *             lists, each component's solutions (over its own variables).
+ */
+void printProduct(int numVars, const cnfComponents *components, const solutionList *lists) {
+    int n = components->numComponents, k;
+    long *index = (long *) calloc(n, sizeof(long));
+
+    for (k = 0; k < n; k++) {
+        if (lists[k].count == 0) {
+            free(index);
+            return;
+        }
+    }
+    for (;;) {
+        cnfWide input = 0;
+        for (k = 0; k < n; k++) {
+            input |= depositBits(lists[k].values[index[k]], components->varMask[k]);
+        }
+        printCnfInput(0, numVars, input);
+
+        // advance the odometer, the last component fastest
+        for (k = n - 1; k >= 0 && ++index[k] == lists[k].count; k--) {
+            index[k] = 0;
+        }
+        if (k < 0) {
+            break;
+        }
+    }
+    free(index);
+}
+
+int main (int argc, char *argv[]) {
+    int id;                              // process id
+    int numProcesses;                    // number of processes
+    unsigned long long *state;           // component, its blocks done, counts (checkpointed)
+    unsigned long long *count;           // number of solutions, per component
+    unsigned long long *globalCount;     // total number across all processes
+    cnfWide product = 1;                 // number of solutions of the circuit
+    long double approximate = 1.0;       // the same, should it not fit a cnfWide
+    int overflow = 0;
+    unsigned long long first, start, stop; // chunk first, (resume) start and stop blocks
+    unsigned long long checked = 0;      // candidates this process checked
+    const char *fileName = "circuit.cnf";
+    const char *checkpointName = NULL;   // -c file: save progress there
+    int enumerate = 0;                   // print the solutions too?
+    int gray = 0;                        // visit the blocks in Gray-code order?
+    int resumed = 0;
+    char digits[40];
+    cnfFormula formula;
+    cnfComponents components;
+    searchCheckpoint checkpoint;
+    solutionList *lists;
+    int i, k, split;
+
+    // Initialize MPI
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-e") == 0) {
+            enumerate = 1;
+        } else if (strcmp(argv[i], "-g") == 0) {
+            gray = 1;
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            checkpointName = argv[++i];
+        } else {
+            fileName = argv[i];
+        }
+    }
+    if (enumerate && checkpointName) {
+        // the solutions found before a checkpoint are not in it
+        if (id == 0) {
+            fprintf(stderr, "-e and -c cannot be used together\n");
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
+    if (!loadCircuit(id, fileName, &formula)) {
+        MPI_Finalize();
+        return 1;
+    }
+    split = splitCnf(&formula, &components);
+    if (split < 0) {
+        if (id == 0) {
+            fprintf(stderr, "%s: a component has more than %d variables, too many to search\n",
+                    fileName, CNF_SEARCH_VARS);
+        }
+        freeFormula(&formula);
+        MPI_Finalize();
+        return 1;
+    } else if (split == 0) {
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    state = (unsigned long long *) calloc(2 + components.numComponents, sizeof(unsigned long long));
+    globalCount = (unsigned long long *) calloc(components.numComponents, sizeof(unsigned long long));
+    lists = (solutionList *) calloc(components.numComponents, sizeof(solutionList));
+    if (!state || !globalCount || !lists) {
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    count = state + 2;
+
+    if (checkpointName) {
+        resumed = openCheckpoint(&checkpoint, checkpointName, formulaSignature(&formula),
+                                 2 + components.numComponents, state);
+        if (resumed < 0) {
+            MPI_Finalize();
+            return 1;
+        }
+    }
+
+    // Start timer for process 0
+    double startTime = 0.0, totalTime = 0.0;
+    if (id == 0) {
+        printf ("\nProcess %d is checking the circuit (%d variables, %d clauses, %d components)...\n",
+                 id, formula.numVars, formula.numClauses, components.numComponents);
+        if (resumed) {
+            printf ("Resuming from %s.\n", checkpointName);
+        }
+        startTime = MPI_Wtime();
+    }
+
+    // Main loop: for each component, check all values in this process's
+    // chunk of its blocks of 64 inputs (those not done before a checkpoint)
+    double loopTime = MPI_Wtime();
+    for (k = (int) state[0]; k < components.numComponents; k++) {
+        const cnfCircuit *part = &components.circuit[k];
+        getChunkStartStopValues(id, numProcesses, cnfBlocks(part), &first, &stop);
+        start = first + state[1];
+        // a block of a component under 6 variables holds only its 2^numVars inputs
+        checked += (stop - start) * __builtin_popcountll(part->validLanes);
+
+        if (gray && start < stop) {
+            cnfGrayWalk walk;
+            if (!startGrayWalk(&walk, part, start)) {
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            for (unsigned long long i = start; ; ) {
+                circuitLanes solutions = evaluateGrayWalk(&walk);
+                count[k] += __builtin_popcountll(solutions);
+                for (; enumerate && solutions; solutions &= solutions - 1) {
+                    appendSolution(&lists[k], walk.base + __builtin_ctzll(solutions));
+                }
+                if (++i == stop) {
+                    break;
+                }
+                if (checkpointName && (i & (CHECKPOINT_POLL_BLOCKS - 1)) == 0) {
+                    state[1] = i - first;
+                    saveCheckpoint(&checkpoint, state, 0);
+                }
+                stepGrayWalk(&walk, i);
+            }
+            freeGrayWalk(&walk);
+        } else if (!gray) {
+            for (unsigned long long i = start; i < stop; i++) {
+                unsigned long long base = i * CIRCUIT_LANES;
+                circuitLanes solutions = evaluateCnfBits(part, base);
+                count[k] += __builtin_popcountll(solutions);
+                for (; enumerate && solutions; solutions &= solutions - 1) {
+                    appendSolution(&lists[k], base + __builtin_ctzll(solutions));
+                }
+                if (checkpointName && ((i + 1) & (CHECKPOINT_POLL_BLOCKS - 1)) == 0) {
+                    state[1] = i + 1 - first;
+                    saveCheckpoint(&checkpoint, state, 0);
+                }
+            }
+        }
+
+        // on to the next component, from the start of its chunk
+        state[0] = k + 1;
+        state[1] = 0;
+    }
+    loopTime = MPI_Wtime() - loopTime;
+    if (checkpointName) {
+        saveCheckpoint(&checkpoint, state, 1);
+        closeCheckpoint(&checkpoint);
+    }
+
+    // Collect results from all processes
+    MPI_Reduce(count, globalCount, components.numComponents, MPI_UNSIGNED_LONG_LONG,
+               MPI_SUM, 0, MPI_COMM_WORLD);
+    for (k = 0; k < components.numComponents; k++) {
+        if (globalCount[k] != 0 && product > ~(cnfWide) 0 / globalCount[k]) {
+            overflow = 1;
+        }
+        product *= globalCount[k];
+        approximate *= globalCount[k];
+    }
+
+    // Print results for process 0
+    if (id == 0) {
+        totalTime = MPI_Wtime() - startTime;
+        for (k = 0; k < components.numComponents; k++) {
+            printf("Component %d: %d variables, %d clauses, %llu solutions\n", k,
+                   components.circuit[k].numVars, components.circuit[k].numClauses, globalCount[k]);
+        }
+        printf ("Process %d finished in time %f secs.\n", id, totalTime);
+        if (overflow) {
+            printf("A total of about %.6Lg solutions were found.\n", approximate);
+        } else {
+            printf("A total of %s solutions were found.\n", wideToString(product, digits));
+        }
+        if (!resumed) {
+            printf("The 2^%d candidate inputs were covered at %.3g candidates/sec.\n",
+                   formula.numVars, ldexp(1.0, formula.numVars) / totalTime);
+        }
+    }
+    reportThroughput(loopTime, checked, components.numComponents);
+
+    // The solutions themselves, only when asked for
+    if (enumerate) {
+        for (k = 0; k < components.numComponents; k++) {
+            gatherSolutions(id, numProcesses, &lists[k]);
+        }
+        if (id == 0) {
+            printProduct(formula.numVars, &components, lists);
+        }
+    }
+
+    for (k = 0; k < components.numComponents; k++) {
+        free(lists[k].values);
+    }
+    free(lists);
+    free(state);
+    free(globalCount);
+    freeCnfComponents(&components);
+    freeFormula(&formula);
+
+    // Finalize MPI
+    MPI_Finalize();
+    return 0;
+}
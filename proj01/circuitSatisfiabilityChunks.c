@@ -3,6 +3,22 @@
  * An adaptation of circuitSatisfiability.c, this program employs MPI for 
  * parallel processing, distributing tasks using the 'Chunks' Parallel Loop pattern.
  *
+ * Usage: mpirun -np N ./circuitSatisfiabilityChunks [-p] [-o solutions.bin] [-d] [-t N] [-k K] [-b R]
+ *   -p  print the solutions, after the timed search (see solutionBuffer.h)
+ *   -o  write them to a binary file of uint32_t inputs
+ *   -d  instead of a fixed share each, processes claim guided chunks of
+ *        the inputs as they go (see selfSchedule.h), so faster nodes do more
+ *   -t  threads per process (default: OMP_NUM_THREADS, else one per core)
+ *   -k  stop once k solutions are found (-k 1: is it satisfiable at all?),
+ *        keep the first k, and report how soon the first was (see earlyStop.h)
+ *   -b  instead of one search, time R runs of it on 1, 2, 4, ... of the
+ *        processes and print CSV with speedup, efficiency and the
+ *        Karp-Flatt serial fraction (see scalingBenchmark.h, make benchmark)
+ *
+ * Each process splits its share among an OpenMP thread team, so a node
+ *  can run one process per socket (or per node) instead of one per core;
+ *  see script_hybrid_*.slurm for the placement and thread pinning.
+ *
  * Author: Yuese Li
  * Institution: Calvin University
  * Course: CS374 (High Performance Computing)
@@ -12,15 +28,23 @@
 
 
 #include <stdio.h>     // printf()
-#include <limits.h>    // UINT_MAX
+#include <string.h>    // strcmp()
+#include <stdlib.h>    // atoi(), atoll()
 #include <mpi.h>       // MPI functions
-
-int checkCircuit (int, long);
+#include <omp.h>       // omp_set_num_threads()
+#include "checkCircuitBits.h" // evaluateCircuitBits()
+#include "solutionBuffer.h" // keepFirstSolutions(), reportSolutions()
+#include "checkBlocks.h" // checkBlock(), checkBlocks(), checkBlocksUntil()
+#include "selfSchedule.h" // nextSelfScheduleChunk()
+#include "throughput.h" // reportThroughput()
+#include "earlyStop.h" // pollEarlyStop()
+#include "scalingBenchmark.h" // runScalingBenchmark()
 
 // Function to calculate start and stop values for each chunk
-void getChunkStartStopValues(int id, int numProcesses, long numIterations, long* start, long* stop) {
-    long chunkSize = numIterations / numProcesses;
-    long remainder = numIterations % numProcesses;
+void getChunkStartStopValues(int id, int numProcesses, unsigned long long numIterations,
+                             unsigned long long* start, unsigned long long* stop) {
+    unsigned long long chunkSize = numIterations / numProcesses;
+    unsigned long long remainder = numIterations % numProcesses;
     
     if (id < remainder) {
         *start = id * (chunkSize + 1);
@@ -31,34 +55,114 @@ void getChunkStartStopValues(int id, int numProcesses, long numIterations, long*
     }
 }
 
+// the smallest chunk -d hands out: 64K inputs, well above the cost of a claim
+#define MIN_CHUNK_BLOCKS 1024
+
+// one run of the search, for the benchmark (its solutions are dropped)
+long long benchmarkChunks(int id, int numProcesses) {
+    static solutionBuffer solutions = {NULL, 0, 0};
+    unsigned long long start, stop;
+
+    solutions.count = 0;
+    getChunkStartStopValues(id, numProcesses, CIRCUIT_BLOCKS, &start, &stop);
+    return checkBlocks(start, stop, &solutions);
+}
+
 int main (int argc, char *argv[]) {
     int id;               // process id 
     int numProcesses;     // number of processes
     int count = 0;        // number of solutions 
-    long start, stop;     // chunk start and stop values
+    unsigned long long start, stop; // chunk start and stop values
     int globalCount = 0;  // total number of solutions across all processes
+    solutionBuffer solutions = {NULL, 0, 0}; // the solutions themselves
+    const char *fileName = NULL; // -o file: write them there (binary uint32)
+    int printThem = 0;    // -p: print them once the search is over
+    int dynamic = 0;      // -d: self-scheduled chunks instead of a fixed share
+    int provided;         // the thread support MPI gives us
+    long long wanted = 0; // -k: stop after this many solutions (0: find all)
+    earlyStop early;      // and how everyone learns there are enough
+    int repetitions = 0;  // -b: benchmark, with this many timed runs
+    unsigned long checked = 0; // blocks this process checked
+    long long chunks = 1; // and in how many pieces
     
     // Initialize MPI
-    MPI_Init(&argc, &argv);
+    // only the master thread calls MPI
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
     MPI_Comm_rank(MPI_COMM_WORLD, &id);
     MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
 
-    // Calculate start and stop values for this process's chunk
-    getChunkStartStopValues(id, numProcesses, UINT_MAX+1L, &start, &stop);
+    for (int arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "-p") == 0) {
+            printThem = 1;
+        } else if (strcmp(argv[arg], "-o") == 0 && arg + 1 < argc) {
+            fileName = argv[++arg];
+        } else if (strcmp(argv[arg], "-d") == 0) {
+            dynamic = 1;
+        } else if (strcmp(argv[arg], "-t") == 0 && arg + 1 < argc) {
+            omp_set_num_threads(atoi(argv[++arg]));
+        } else if (strcmp(argv[arg], "-k") == 0 && arg + 1 < argc) {
+            wanted = atoll(argv[++arg]);
+        } else if (strcmp(argv[arg], "-b") == 0 && arg + 1 < argc) {
+            repetitions = atoi(argv[++arg]);
+        }
+    }
+
+    if (repetitions > 0) {
+        runScalingBenchmark("chunks", benchmarkChunks, repetitions);
+        MPI_Finalize();
+        return 0;
+    }
+
+    selfSchedule schedule;
+    if (dynamic) {
+        createSelfSchedule(&schedule, CIRCUIT_BLOCKS, MIN_CHUNK_BLOCKS);
+    } else {
+        // Calculate start and stop values for this process's chunk of the
+        // blocks of 64 inputs
+        getChunkStartStopValues(id, numProcesses, CIRCUIT_BLOCKS, &start, &stop);
+    }
 
     // Start timer for process 0
     double startTime = 0.0, totalTime = 0.0;
     if (id == 0) {
-        printf ("\nProcess %d is checking the circuit...\n", id);
+        printf ("\nProcess %d is checking the circuit (%d processes x %d threads)...\n",
+                id, numProcesses, omp_get_max_threads());
+        if (wanted) {
+            printf ("Stopping once %lld solutions are found.\n", wanted);
+        }
         startTime = MPI_Wtime();
     }
 
     // Main loop: check the circuit for all values in this process's chunk
-    for (long i = start; i < stop; i++) {
-        count += checkCircuit(id, i);
+    // (or in every chunk it manages to claim)
+    if (wanted) {
+        createEarlyStop(&early, wanted);
+    }
+    double loopTime = MPI_Wtime();
+    if (dynamic) {
+        unsigned long long first, last;
+        while (!(wanted && early.done) && nextSelfScheduleChunk(&schedule, &first, &last)) {
+            if (wanted) {
+                count += checkBlocksUntil(first, last, &solutions, &early, &checked);
+            } else {
+                count += checkBlocks(first, last, &solutions);
+                checked += last - first;
+            }
+        }
+        chunks = schedule.chunksClaimed;
+    } else if (wanted) {
+        count += checkBlocksUntil(start, stop, &solutions, &early, &checked);
+    } else {
+        count += checkBlocks(start, stop, &solutions);
+        checked = stop - start;
     }
+    loopTime = MPI_Wtime() - loopTime;
 
-    // Collect results from all processes
+    // Collect results from all processes: with -k, the first k of them only,
+    // as processes that found some in the same poll interval all kept theirs
+    if (wanted) {
+        count = (int) keepFirstSolutions(&solutions, wanted);
+    }
     MPI_Reduce(&count, &globalCount, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
 
     // Print results for process 0
@@ -67,68 +171,20 @@ int main (int argc, char *argv[]) {
         printf ("Process %d finished in time %f secs.\n", id, totalTime);
         printf("A total of %d solutions were found.\n", globalCount);
     }
+    if (wanted) {
+        reportEarlyStop(&early);
+        freeEarlyStop(&early);
+    }
+    reportThroughput(loopTime, checked * CIRCUIT_LANES, chunks);
+    if (dynamic) {
+        freeSelfSchedule(&schedule);
+    }
+
+    // Post-processing, outside the timing: the solutions themselves
+    reportSolutions(&solutions, fileName, printThem);
+    free(solutions.values);
 
     // Finalize MPI
     MPI_Finalize();
     return 0;
 }
-
-/* EXTRACT_BIT is a macro that extracts the ith bit of number n.
- *
- * parameters: n, a number;
- *             i, the position of the bit we want to know.
- *
- * return: 1 if 'i'th bit of 'n' is 1; 0 otherwise 
- */
-
-#define EXTRACT_BIT(n,i) ((n & (1<<i)) ? 1 : 0)
-
-/* checkCircuit() checks the circuit for a given input.
- * parameters: id, the id of the process checking;
- *             bits, the (long) rep. of the input being checked.
- *
- * output: the binary rep. of bits if the circuit outputs 1
- * return: 1 if the circuit outputs 1; 0 otherwise.
- */
-
-#define SIZE 32
-
-int checkCircuit (int id, long bits) {
-   int v[SIZE];        /* Each element is one of the 32 bits */
-   int i;
-
-   for (i = 0; i < SIZE; i++) {
-     v[i] = EXTRACT_BIT(bits,i);
-   }
-
-   if ( ( (v[0] || v[1]) && (!v[1] || !v[3]) && (v[2] || v[3])
-       && (!v[3] || !v[4]) && (v[4] || !v[5])
-       && (v[5] || !v[6]) && (v[5] || v[6])
-       && (v[6] || !v[15]) && (v[7] || !v[8])
-       && (!v[7] || !v[13]) && (v[8] || v[9])
-       && (v[8] || !v[9]) && (!v[9] || !v[10])
-       && (v[9] || v[11]) && (v[10] || v[11])
-       && (v[12] || v[13]) && (v[13] || !v[14])
-       && (v[14] || v[15]) )
-       &&
-          ( (v[16] || v[17]) && (!v[17] || !v[19]) && (v[18] || v[19])
-       && (!v[19] || !v[20]) && (v[20] || !v[21])
-       && (v[21] || !v[22]) && (v[21] || v[22])
-       && (v[22] || !v[31]) && (v[23] || !v[24])
-       && (!v[23] || !v[29]) && (v[24] || v[25])
-       && (v[24] || !v[25]) && (!v[25] || !v[26])
-       && (v[25] || v[27]) && (v[26] || v[27])
-       && (v[28] || v[29]) && (v[29] || !v[30])
-       && (v[30] || v[31]) ) )
-   {
-      printf ("%d) %d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d \n", id,
-         v[31],v[30],v[29],v[28],v[27],v[26],v[25],v[24],v[23],v[22],
-         v[21],v[20],v[19],v[18],v[17],v[16],v[15],v[14],v[13],v[12],
-         v[11],v[10],v[9],v[8],v[7],v[6],v[5],v[4],v[3],v[2],v[1],v[0]);
-      fflush (stdout);
-      return 1;
-   } else {
-      return 0;
-   }
-}
-
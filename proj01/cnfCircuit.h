@@ -0,0 +1,608 @@
+/* cnfCircuit.h loads a circuit in DIMACS CNF form and checks it
+ *  64 inputs at a time, like checkCircuitBits.h does for the built-in one.
+ *
+ * Variable k of the file (k = 1 .. numVars) is bit k-1 of an input.
+ *  Each clause is compiled into a pair of bitmasks, positive and negative,
+ *  holding the variables that appear in it plain and negated; input x
+ *  satisfies the clause iff (x & positive) | (~x & negative) is nonzero.
+ *
+ * For the block of 64 inputs base .. base+63, the bits above the low 6
+ *  are the same in every lane, so a clause that those bits satisfy holds
+ *  in every lane; otherwise it holds in exactly the lanes of its
+ *  precomputed lowLanes word (the OR of the lane patterns of its low
+ *  literals).  A block is the AND of one such word per clause, and stops
+ *  early once no lane is left.
+ *
+ * A file may have up to 128 variables, read into a cnfFormula of 128-bit
+ *  masks; the search itself runs on the formula's independent components
+ *  (splitCnf()), each a cnfCircuit of at most 64 variables, whose inputs
+ *  fit in an unsigned long long.
+ *
+ * Usage: cnfFormula formula;
+ *        cnfComponents components;
+ *        if (readCnf("circuit.cnf", &formula) && splitCnf(&formula, &components) > 0) {
+ *            for (block = first; block < last; block++)
+ *                count += checkCnfBits(id, &components.circuit[k], block * CIRCUIT_LANES);
+ *            ...
+ *        }
+ */
+
+#ifndef CNF_CIRCUIT
+#define CNF_CIRCUIT
+
+#include <stdio.h>     // printf(), fopen()
+#include <stdlib.h>    // malloc()
+#include <stdint.h>    // uint64_t
+#include "checkCircuitBits.h" // circuitLanes, lanePattern
+
+#define CNF_MAX_VARS    128 // variables in a circuit file
+#define CNF_SEARCH_VARS 64  // in a component: its inputs are unsigned long longs
+
+// an input of a whole circuit file
+__extension__ typedef unsigned __int128 cnfWide;
+
+// the clauses of a circuit file, as read, before splitCnf()
+typedef struct {
+    int numVars;
+    int numClauses;
+    cnfWide *positive;      // per clause: the variables that appear plain
+    cnfWide *negative;      //  ... and negated
+} cnfFormula;
+
+typedef struct {
+    int numVars;            // inputs have numVars bits
+    int numClauses;
+    uint64_t *positive;     // per clause: the variables that appear plain
+    uint64_t *negative;     //  ... and negated
+    circuitLanes *lowLanes; // per clause: the lanes its low 6 bits satisfy
+    circuitLanes validLanes; // lanes < 2^numVars (all, once numVars >= 6)
+} cnfCircuit;
+
+/* cnfBlocks() counts the blocks of 64 inputs that cover the circuit.
+ * return: 2^(numVars-6), or 1 for circuits of fewer than 6 variables.
+ */
+static inline unsigned long long cnfBlocks(const cnfCircuit *circuit) {
+    return circuit->numVars > 6 ? 1ULL << (circuit->numVars - 6) : 1ULL;
+}
+
+/* prepareCnf() builds lowLanes and validLanes from positive and negative.
+ * Precondition: numVars, numClauses, positive and negative are set
+ *                and lowLanes has room for numClauses words.
+ */
+static void prepareCnf(cnfCircuit *circuit) {
+    int c, i;
+
+    for (c = 0; c < circuit->numClauses; c++) {
+        circuitLanes lanes = 0;
+        for (i = 0; i < 6; i++) {
+            if ((circuit->positive[c] >> i) & 1) {
+                lanes |= lanePattern[i];
+            }
+            if ((circuit->negative[c] >> i) & 1) {
+                lanes |= ~lanePattern[i];
+            }
+        }
+        circuit->lowLanes[c] = lanes;
+    }
+
+    circuit->validLanes = circuit->numVars >= 6 ? ~(circuitLanes)0
+                          : (((circuitLanes)1 << (1 << circuit->numVars)) - 1);
+}
+
+/* allocateCnf() makes room for a circuit of numClauses clauses.
+ * return: 1 on success; 0 (and an empty circuit) if out of memory.
+ */
+static int allocateCnf(cnfCircuit *circuit, int numVars, int numClauses) {
+    circuit->numVars = numVars;
+    circuit->numClauses = numClauses;
+    circuit->positive = (uint64_t *) calloc(numClauses + 1, sizeof(uint64_t));
+    circuit->negative = (uint64_t *) calloc(numClauses + 1, sizeof(uint64_t));
+    circuit->lowLanes = (circuitLanes *) calloc(numClauses + 1, sizeof(circuitLanes));
+    if (!circuit->positive || !circuit->negative || !circuit->lowLanes) {
+        free(circuit->positive);
+        free(circuit->negative);
+        free(circuit->lowLanes);
+        circuit->positive = circuit->negative = NULL;
+        circuit->lowLanes = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+static void freeCnf(cnfCircuit *circuit) {
+    free(circuit->positive);
+    free(circuit->negative);
+    free(circuit->lowLanes);
+}
+
+/* allocateFormula() makes room for a formula of numClauses clauses.
+ * return: 1 on success; 0 (and an empty formula) if out of memory.
+ */
+static int allocateFormula(cnfFormula *formula, int numVars, int numClauses) {
+    formula->numVars = numVars;
+    formula->numClauses = numClauses;
+    formula->positive = (cnfWide *) calloc(numClauses + 1, sizeof(cnfWide));
+    formula->negative = (cnfWide *) calloc(numClauses + 1, sizeof(cnfWide));
+    if (!formula->positive || !formula->negative) {
+        free(formula->positive);
+        free(formula->negative);
+        formula->positive = formula->negative = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+static void freeFormula(cnfFormula *formula) {
+    free(formula->positive);
+    free(formula->negative);
+}
+
+// the lowest set bit, and the number of set bits, of a nonzero cnfWide
+static inline int wideCtz(cnfWide x) {
+    uint64_t low = (uint64_t) x;
+    return low ? __builtin_ctzll(low) : 64 + __builtin_ctzll((uint64_t) (x >> 64));
+}
+
+static inline int widePopcount(cnfWide x) {
+    return __builtin_popcountll((uint64_t) x) + __builtin_popcountll((uint64_t) (x >> 64));
+}
+
+/* wideToString() writes x in decimal (up to 39 digits) into digits.
+ * return: digits.
+ */
+static char *wideToString(cnfWide x, char digits[40]) {
+    char reversed[40];
+    int n = 0, i;
+
+    do {
+        reversed[n++] = (char) ('0' + (int) (x % 10));
+        x /= 10;
+    } while (x);
+    for (i = 0; i < n; i++) {
+        digits[i] = reversed[n - 1 - i];
+    }
+    digits[n] = '\0';
+    return digits;
+}
+
+/* readCnf() loads a DIMACS CNF file:
+ *   c comment lines
+ *   p cnf <numVars> <numClauses>
+ *   clauses, each a list of nonzero literals (k or -k) ended by 0
+ * Clauses that contain both k and -k always hold and are dropped.
+ *
+ * parameters: fileName, the file to read;
+ *             formula, where to put the result.
+ * return: 1 on success; 0 (after printing why) otherwise.
+ */
+static int readCnf(const char *fileName, cnfFormula *formula) {
+    FILE *file = fopen(fileName, "r");
+    int numVars = 0, numClauses = 0, literal, c = 0, tautologies = 0, unterminated = 0, found = 0;
+    char line[1024];
+
+    if (file == NULL) {
+        perror(fileName);
+        return 0;
+    }
+
+    // skip comments up to the problem line
+    line[0] = '\0';
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (line[0] == 'p') {
+            found = 1;
+            break;
+        }
+    }
+    if (!found || sscanf(line, "p cnf %d %d", &numVars, &numClauses) != 2
+         || numVars < 1 || numVars > CNF_MAX_VARS || numClauses < 0) {
+        fprintf(stderr, "%s: expected 'p cnf <1..%d variables> <clauses>'\n",
+                 fileName, CNF_MAX_VARS);
+        fclose(file);
+        return 0;
+    }
+    if (!allocateFormula(formula, numVars, numClauses)) {
+        fprintf(stderr, "%s: out of memory\n", fileName);
+        fclose(file);
+        return 0;
+    }
+
+    while (c + tautologies < numClauses && fscanf(file, "%d", &literal) == 1) {
+        unterminated = literal != 0;
+        if (literal == 0) {
+            // keep the clause unless it is a tautology
+            if ((formula->positive[c] & formula->negative[c]) == 0) {
+                c++;
+            } else {
+                formula->positive[c] = formula->negative[c] = 0;
+                tautologies++;
+            }
+        } else if (literal > numVars || -literal > numVars) {
+            fprintf(stderr, "%s: literal %d is not one of %d variables\n",
+                     fileName, literal, numVars);
+            freeFormula(formula);
+            fclose(file);
+            return 0;
+        } else if (literal > 0) {
+            formula->positive[c] |= (cnfWide) 1 << (literal - 1);
+        } else {
+            formula->negative[c] |= (cnfWide) 1 << (-literal - 1);
+        }
+    }
+    fclose(file);
+
+    // a comment, a stray token or the end of the file before the last clause
+    if (unterminated || c + tautologies < numClauses) {
+        if (unterminated) {
+            fprintf(stderr, "%s: clause %d has no terminating 0\n", fileName,
+                     c + tautologies + 1);
+        } else {
+            fprintf(stderr, "%s: found %d of the %d clauses declared\n", fileName,
+                     c + tautologies, numClauses);
+        }
+        freeFormula(formula);
+        return 0;
+    }
+    formula->numClauses = c;    // less any tautologies
+    return 1;
+}
+
+/* evaluateCnfBits() evaluates the circuit for 64 inputs.
+ * parameters: circuit, a circuit from readCnf();
+ *             base, the first of the inputs (a multiple of 64).
+ *
+ * return: a word with bit k set iff input base+k satisfies every clause.
+ */
+static inline circuitLanes evaluateCnfBits(const cnfCircuit *circuit,
+                                           unsigned long long base) {
+    circuitLanes result = circuit->validLanes;
+    int c;
+
+    for (c = 0; c < circuit->numClauses && result; c++) {
+        if (((base & circuit->positive[c]) | (~base & circuit->negative[c])) >> 6 == 0) {
+            // no literal above the low 6 bits holds: the lanes decide
+            result &= circuit->lowLanes[c];
+        }
+    }
+    return result;
+}
+
+/* printCnfInput() prints a satisfying input, in the format of printCircuitInput().
+ * parameters: id, the id of the process checking;
+ *             numVars, the number of bits to print;
+ *             input, the input (most significant bit first).
+ */
+static inline void printCnfInput(int id, int numVars, cnfWide input) {
+    char digits[CNF_MAX_VARS + 1];
+    int i;
+
+    for (i = 0; i < numVars; i++) {
+        digits[i] = ((input >> (numVars - 1 - i)) & 1) ? '1' : '0';
+    }
+    digits[numVars] = '\0';
+    printf ("%d) %s \n", id, digits);
+    fflush (stdout);
+}
+
+/* checkCnfBits() checks the circuit for 64 inputs.
+ * parameters: id, the id of the process checking;
+ *             circuit, a circuit from readCnf();
+ *             base, the first of the inputs (a multiple of 64).
+ *
+ * output: the binary rep. of each input that satisfies the circuit
+ * return: the number of those inputs.
+ */
+static inline int checkCnfBits(int id, const cnfCircuit *circuit,
+                               unsigned long long base) {
+    circuitLanes solutions = evaluateCnfBits(circuit, base);
+    int count = __builtin_popcountll(solutions);
+
+    while (solutions) {
+        printCnfInput(id, circuit->numVars, base + __builtin_ctzll(solutions));
+        solutions &= solutions - 1;    // clear the lowest solution
+    }
+    return count;
+}
+
+/* Independent sub-circuits
+ *
+ * Clauses that share no variable constrain their inputs independently,
+ *  so the circuit's solutions are the Cartesian product of those of its
+ *  variable-disjoint components, and its count the product of theirs.
+ *  splitCnf() finds the components with union-find over the variables
+ *  (each clause joins all of its variables) and makes each one a circuit
+ *  of its own, over just its variables, renumbered from bit 0 up.
+ *  A variable that appears in no clause is a component of 2 solutions.
+ */
+
+typedef struct {
+    int numComponents;
+    cnfWide *varMask;       // per component: its variables, as bits of an input
+    cnfCircuit *circuit;    // per component: its clauses, over compacted variables
+} cnfComponents;
+
+/* findRoot() finds the representative of variable v (halving the path).
+ */
+static int findRoot(int *parent, int v) {
+    while (parent[v] != v) {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
+}
+
+/* compressBits() packs the bits of x selected by mask into the low bits.
+ * Precondition: mask has at most 64 bits set.
+ */
+static inline uint64_t compressBits(cnfWide x, cnfWide mask) {
+    uint64_t result = 0;
+    int k = 0;
+
+    for (; mask; mask &= mask - 1, k++) {
+        if (x & mask & -mask) {
+            result |= 1ULL << k;
+        }
+    }
+    return result;
+}
+
+/* depositBits() spreads the low bits of x out to the bits set in mask
+ *  (the inverse of compressBits()).
+ */
+static inline cnfWide depositBits(uint64_t x, cnfWide mask) {
+    cnfWide result = 0;
+
+    for (; mask; mask &= mask - 1, x >>= 1) {
+        if (x & 1) {
+            result |= mask & -mask;
+        }
+    }
+    return result;
+}
+
+static void freeCnfComponents(cnfComponents *components) {
+    int k;
+
+    for (k = 0; k < components->numComponents; k++) {
+        freeCnf(&components->circuit[k]);
+    }
+    free(components->varMask);
+    free(components->circuit);
+}
+
+/* splitCnf() splits a formula into its independent components.
+ * parameters: formula, a formula from readCnf();
+ *             components, where to put them.
+ * Postcondition: the components' varMasks partition the variables,
+ *                 in order of their lowest variable, and every clause of
+ *                 formula is in the component of its variables (a clause
+ *                 with no literals, which no input satisfies, in the first).
+ * return: 1 on success; 0 if out of memory; -1 (and no components) if a
+ *          component has more than CNF_SEARCH_VARS variables.
+ */
+static int splitCnf(const cnfFormula *formula, cnfComponents *components) {
+    int numVars = formula->numVars;
+    int parent[CNF_MAX_VARS], componentOf[CNF_MAX_VARS], numClauses[CNF_MAX_VARS];
+    int v, c, k;
+
+    for (v = 0; v < numVars; v++) {
+        parent[v] = v;
+    }
+    for (c = 0; c < formula->numClauses; c++) {
+        cnfWide vars = formula->positive[c] | formula->negative[c];
+        if (vars) {
+            int first = findRoot(parent, wideCtz(vars));
+            for (vars &= vars - 1; vars; vars &= vars - 1) {
+                parent[findRoot(parent, wideCtz(vars))] = first;
+            }
+        }
+    }
+
+    // number the components in order of their lowest variable
+    components->numComponents = 0;
+    components->varMask = (cnfWide *) calloc(numVars, sizeof(cnfWide));
+    components->circuit = (cnfCircuit *) calloc(numVars, sizeof(cnfCircuit));
+    if (!components->varMask || !components->circuit) {
+        free(components->varMask);
+        free(components->circuit);
+        return 0;
+    }
+    for (v = 0; v < numVars; v++) {
+        componentOf[v] = -1;    // indexed by root
+    }
+    for (v = 0; v < numVars; v++) {
+        int root = findRoot(parent, v);
+        if (componentOf[root] < 0) {
+            componentOf[root] = components->numComponents++;
+            numClauses[componentOf[root]] = 0;
+        }
+        components->varMask[componentOf[root]] |= (cnfWide) 1 << v;
+    }
+    for (k = 0; k < components->numComponents; k++) {
+        if (widePopcount(components->varMask[k]) > CNF_SEARCH_VARS) {
+            free(components->varMask);
+            free(components->circuit);
+            components->numComponents = 0;
+            return -1;
+        }
+    }
+
+    // deal the clauses out to their components
+    for (c = 0; c < formula->numClauses; c++) {
+        cnfWide vars = formula->positive[c] | formula->negative[c];
+        numClauses[vars ? componentOf[findRoot(parent, wideCtz(vars))] : 0]++;
+    }
+    for (k = 0; k < components->numComponents; k++) {
+        if (!allocateCnf(&components->circuit[k], widePopcount(components->varMask[k]),
+                          numClauses[k])) {
+            components->numComponents = k;
+            freeCnfComponents(components);
+            return 0;
+        }
+        numClauses[k] = 0;
+    }
+    for (c = 0; c < formula->numClauses; c++) {
+        cnfWide vars = formula->positive[c] | formula->negative[c];
+        k = vars ? componentOf[findRoot(parent, wideCtz(vars))] : 0;
+        cnfCircuit *part = &components->circuit[k];
+        part->positive[numClauses[k]] = compressBits(formula->positive[c], components->varMask[k]);
+        part->negative[numClauses[k]] = compressBits(formula->negative[c], components->varMask[k]);
+        numClauses[k]++;
+    }
+    for (k = 0; k < components->numComponents; k++) {
+        prepareCnf(&components->circuit[k]);
+    }
+    return 1;
+}
+
+/* Gray-code walks
+ *
+ * Instead of testing every clause against every block, a walk visits the
+ *  blocks of 64 inputs in the order gray(first), gray(first+1), ... where
+ *  gray(i) = i ^ (i >> 1): consecutive blocks differ in one variable
+ *  above the low 6 (bit ctz(i) of step i), so only the clauses that
+ *  variable appears in change.  The walk keeps, per clause, how many of
+ *  its high literals are true, and the set of "open" clauses that have
+ *  none, which are the only ones the low 6 bits (the lanes) still decide.
+ *  A step costs O(occurrences of the flipped variable), and a block is
+ *  the AND of the open clauses' lowLanes -- or nothing at all, while an
+ *  open clause has no low literal.
+ *
+ * Since gray() permutes 0 .. 2^(numVars-6)-1, walking every index of a
+ *  range partition visits every block exactly once.
+ */
+
+typedef struct {
+    const cnfCircuit *circuit;
+    int *start;             // variable v occurs in occurrence[start[v] .. start[v+1])
+    int *occurrence;        // clause index * 2, + 1 where the literal is negated
+    int *trueLiterals;      // per clause: its true literals above the low 6 bits
+    int *open;              // the clauses with none, in no particular order
+    int *openAt;            // per clause: its place in open, or -1
+    int numOpen;
+    int numDead;            // open clauses with no low literal (so no lane)
+    unsigned long long base; // first input of the current block
+} cnfGrayWalk;
+
+static inline unsigned long long grayCode(unsigned long long index) {
+    return index ^ (index >> 1);
+}
+
+static void freeGrayWalk(cnfGrayWalk *walk) {
+    free(walk->start);
+    free(walk->occurrence);
+    free(walk->trueLiterals);
+    free(walk->open);
+    free(walk->openAt);
+}
+
+static inline void openClause(cnfGrayWalk *walk, int c) {
+    walk->openAt[c] = walk->numOpen;
+    walk->open[walk->numOpen++] = c;
+    walk->numDead += walk->circuit->lowLanes[c] == 0;
+}
+
+static inline void closeClause(cnfGrayWalk *walk, int c) {
+    int last = walk->open[--walk->numOpen];
+    walk->open[walk->openAt[c]] = last;
+    walk->openAt[last] = walk->openAt[c];
+    walk->openAt[c] = -1;
+    walk->numDead -= walk->circuit->lowLanes[c] == 0;
+}
+
+/* startGrayWalk() sets up a walk of circuit at block grayCode(index).
+ * return: 1 on success; 0 if out of memory.
+ */
+static int startGrayWalk(cnfGrayWalk *walk, const cnfCircuit *circuit,
+                         unsigned long long index) {
+    const uint64_t high = ~(uint64_t)63;    // the variables above the low 6
+    int numVars = circuit->numVars, numClauses = circuit->numClauses, v, c;
+    int numOccurrences = 0;
+
+    walk->circuit = circuit;
+    walk->base = grayCode(index) * CIRCUIT_LANES;
+    walk->numOpen = walk->numDead = 0;
+    for (c = 0; c < numClauses; c++) {
+        numOccurrences += __builtin_popcountll((circuit->positive[c] | circuit->negative[c]) & high);
+    }
+    walk->start = (int *) calloc(numVars + 1, sizeof(int));
+    walk->occurrence = (int *) malloc((numOccurrences + 1) * sizeof(int));
+    walk->trueLiterals = (int *) calloc(numClauses + 1, sizeof(int));
+    walk->open = (int *) malloc((numClauses + 1) * sizeof(int));
+    walk->openAt = (int *) malloc((numClauses + 1) * sizeof(int));
+    if (!walk->start || !walk->occurrence || !walk->trueLiterals || !walk->open || !walk->openAt) {
+        freeGrayWalk(walk);
+        return 0;
+    }
+
+    // bucket the high literals by variable (start[v+1] counts, then sums, them)
+    for (c = 0; c < numClauses; c++) {
+        uint64_t vars = (circuit->positive[c] | circuit->negative[c]) & high;
+        for (; vars; vars &= vars - 1) {
+            walk->start[__builtin_ctzll(vars) + 1]++;
+        }
+    }
+    for (v = 0; v < numVars; v++) {
+        walk->start[v + 1] += walk->start[v];
+    }
+    for (c = 0; c < numClauses; c++) {
+        uint64_t vars = (circuit->positive[c] | circuit->negative[c]) & high;
+        for (; vars; vars &= vars - 1) {
+            v = __builtin_ctzll(vars);
+            walk->occurrence[walk->start[v]++] = 2 * c + (int) ((circuit->negative[c] >> v) & 1);
+        }
+    }
+    for (v = numVars; v > 0; v--) {
+        walk->start[v] = walk->start[v - 1];
+    }
+    walk->start[0] = 0;
+
+    // evaluate the first block in full
+    for (c = 0; c < numClauses; c++) {
+        walk->trueLiterals[c] = __builtin_popcountll(((walk->base & circuit->positive[c])
+                                                       | (~walk->base & circuit->negative[c])) & high);
+        walk->openAt[c] = -1;
+        if (walk->trueLiterals[c] == 0) {
+            openClause(walk, c);
+        }
+    }
+    return 1;
+}
+
+/* stepGrayWalk() moves the walk from block index-1 on to block index.
+ * Precondition: the walk is at block grayCode(index - 1).
+ * Postcondition: it is at block grayCode(index), with the open set up to date.
+ */
+static inline void stepGrayWalk(cnfGrayWalk *walk, unsigned long long index) {
+    int v = __builtin_ctzll(index) + 6, k;
+    int nowTrue;            // the plain literal of v is now true
+
+    walk->base ^= 1ULL << v;
+    nowTrue = (int) ((walk->base >> v) & 1);
+    for (k = walk->start[v]; k < walk->start[v + 1]; k++) {
+        int c = walk->occurrence[k] >> 1;
+        int negated = walk->occurrence[k] & 1;
+        if (negated != nowTrue) {
+            // this literal became true
+            if (walk->trueLiterals[c]++ == 0) {
+                closeClause(walk, c);
+            }
+        } else if (--walk->trueLiterals[c] == 0) {
+            openClause(walk, c);
+        }
+    }
+}
+
+/* evaluateGrayWalk() evaluates the circuit for the walk's current block.
+ * return: a word with bit k set iff input base+k satisfies every clause.
+ */
+static inline circuitLanes evaluateGrayWalk(const cnfGrayWalk *walk) {
+    circuitLanes result = walk->numDead ? 0 : walk->circuit->validLanes;
+    int k;
+
+    for (k = 0; k < walk->numOpen && result; k++) {
+        result &= walk->circuit->lowLanes[walk->open[k]];
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,119 @@
+/* earlyStop.h lets a search stop as soon as enough solutions are found,
+ *  instead of sweeping all its inputs.
+ *
+ * The processes share one counter, the number of solutions found so far,
+ *  in an MPI window on process 0. Every pollEarlyStop() a process adds the
+ *  solutions it found since the last one with MPI_Fetch_and_op and reads
+ *  the total back in the same call, so no process has to wait for, or
+ *  answer, any other; once the total reaches the number wanted, everyone
+ *  sees it at their next poll and drops the rest of their inputs.
+ *
+ * The solutions kept are the first ones found, not the smallest ones, and
+ *  processes that find some in the same poll interval all keep theirs: each
+ *  may check up to STOP_POLL_BLOCKS blocks after the total was reached, so
+ *  on P processes there may be up to P x STOP_POLL_BLOCKS x 64 inputs' worth
+ *  more than wanted. keepFirstSolutions() (solutionBuffer.h) trims them.
+ *
+ * Usage: earlyStop stop;
+ *        createEarlyStop(&stop, wanted);
+ *        while (... && !stop.done) {
+ *            ...  check the next STOP_POLL_BLOCKS blocks, finding n solutions
+ *            pollEarlyStop(&stop, n);
+ *        }
+ *        reportEarlyStop(&stop);
+ *        freeEarlyStop(&stop);
+ */
+
+#ifndef EARLY_STOP
+#define EARLY_STOP
+
+#include <stdio.h>     // printf()
+#include <mpi.h>       // MPI functions
+
+// blocks of 64 inputs checked between polls: 256K inputs, a fraction of a
+// millisecond of work, and far more than the cost of one MPI_Fetch_and_op
+#define STOP_POLL_BLOCKS 4096
+
+typedef struct {
+    MPI_Win window;               // holds the solutions found, on process 0
+    long long *found;             // that counter (process 0 only)
+    long long wanted;             // stop once this many are found
+    int done;                     // this process has seen enough found
+    double startTime;             // when the search started, here
+    double firstTime;             // when this process found its first (-1: not yet)
+} earlyStop;
+
+/* createEarlyStop() starts a search that stops after wanted solutions.
+ * Precondition: every process calls this, with the same wanted, right
+ *                before its search.
+ */
+static void createEarlyStop(earlyStop *stop, long long wanted) {
+    int id;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Win_allocate(id == 0 ? sizeof(long long) : 0, sizeof(long long), MPI_INFO_NULL,
+                     MPI_COMM_WORLD, &stop->found, &stop->window);
+    if (id == 0) {
+        *stop->found = 0;
+    }
+    stop->wanted = wanted;
+    stop->done = wanted <= 0;
+    stop->firstTime = -1.0;
+    MPI_Barrier(MPI_COMM_WORLD);    // the counter is 0, and everyone starts together
+    MPI_Win_lock_all(0, stop->window);
+    stop->startTime = MPI_Wtime();
+}
+
+/* pollEarlyStop() adds this process's new solutions to the shared count
+ *  and checks whether the search is over.
+ * parameters: newSolutions, the solutions found since the last poll.
+ * Postcondition: stop->done is 1 if, as far as we know, enough were found.
+ * return: stop->done.
+ */
+static int pollEarlyStop(earlyStop *stop, long long newSolutions) {
+    long long before;
+
+    if (newSolutions > 0 && stop->firstTime < 0) {
+        stop->firstTime = MPI_Wtime() - stop->startTime;
+    }
+    MPI_Fetch_and_op(&newSolutions, &before, MPI_LONG_LONG, 0, 0,
+                     newSolutions > 0 ? MPI_SUM : MPI_NO_OP, stop->window);
+    MPI_Win_flush(0, stop->window);
+    if (before + newSolutions >= stop->wanted) {
+        stop->done = 1;
+    }
+    return stop->done;
+}
+
+/* reportEarlyStop() prints, on process 0, how long it took to find the
+ *  first solution and how long to stop.
+ * Precondition: every process calls this, after its search.
+ */
+static void reportEarlyStop(const earlyStop *stop) {
+    int id;
+    double times[2], slowest[2];
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    // the earliest first solution, as a max of negated times
+    times[0] = stop->firstTime < 0 ? -1e300 : -stop->firstTime;
+    times[1] = MPI_Wtime() - stop->startTime;
+    MPI_Reduce(times, slowest, 2, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (id == 0) {
+        if (slowest[0] > -1e300) {
+            printf("The first solution was found after %f secs.\n", -slowest[0]);
+        } else {
+            printf("No solution was found.\n");
+        }
+        printf("Every process had stopped after %f secs.\n", slowest[1]);
+    }
+}
+
+/* freeEarlyStop() releases the window.
+ * Precondition: every process calls this, after its last poll.
+ */
+static void freeEarlyStop(earlyStop *stop) {
+    MPI_Win_unlock_all(stop->window);
+    MPI_Win_free(&stop->window);
+}
+
+#endif
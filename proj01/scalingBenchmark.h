@@ -0,0 +1,132 @@
+/* scalingBenchmark.h times a search on 1, 2, 4, ... processes in one
+ *  mpirun, in place of a batch script and a slurm-*.out file per count.
+ *
+ * For each process count p (the powers of 2 below the number of
+ *  processes, and that number itself), the first p processes are split
+ *  off into a communicator of their own and run the search a few times
+ *  untimed (warm-up) and then repetitions times timed, each run timed
+ *  from a barrier to the slowest process's finish. The others wait,
+ *  sleeping rather than spinning so they do not steal their cores.
+ *  Process 0 then prints one CSV line per count: the min, median and max
+ *  time, and, from the medians, the speedup over 1 process, the
+ *  efficiency, and the Karp-Flatt serial fraction
+ *  e = (1/speedup - 1/p) / (1 - 1/p).
+ *
+ * Usage: long long search(int id, int numProcesses) { ... }
+ *        runScalingBenchmark("chunks", search, repetitions);
+ */
+
+#ifndef SCALING_BENCHMARK
+#define SCALING_BENCHMARK
+
+#include <stdio.h>     // printf()
+#include <stdlib.h>    // malloc(), qsort()
+#include <time.h>      // nanosleep()
+#include <mpi.h>       // MPI functions
+#include <omp.h>       // omp_get_max_threads()
+
+#define BENCHMARK_WARMUPS 1   // untimed runs before the timed ones
+
+// the search to time: its share, as process id of numProcesses
+typedef long long (*benchmarkSearch)(int id, int numProcesses);
+
+static int compareTimes(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+/* waitIdle() waits for request without keeping a core busy.
+ */
+static void waitIdle(MPI_Request *request) {
+    struct timespec pause = {0, 1000000};    // 1 ms
+    int done = 0;
+
+    MPI_Test(request, &done, MPI_STATUS_IGNORE);
+    while (!done) {
+        nanosleep(&pause, NULL);
+        MPI_Test(request, &done, MPI_STATUS_IGNORE);
+    }
+}
+
+/* timeSearch() runs search once on the processes of comm.
+ * return: on process 0 of comm, the time of the slowest of them.
+ */
+static double timeSearch(MPI_Comm comm, benchmarkSearch search) {
+    int id, numProcesses;
+    double seconds, slowest = 0.0;
+
+    MPI_Comm_rank(comm, &id);
+    MPI_Comm_size(comm, &numProcesses);
+    MPI_Barrier(comm);
+    seconds = MPI_Wtime();
+    search(id, numProcesses);
+    seconds = MPI_Wtime() - seconds;
+    MPI_Reduce(&seconds, &slowest, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+    return slowest;
+}
+
+/* runScalingBenchmark() times search on ever more processes and prints
+ *  the results, as CSV with a header line, on process 0.
+ * parameters: partition, the name of the search, for the first column;
+ *             search, the search;
+ *             repetitions, the timed runs per process count.
+ * Precondition: every process calls this, with the same arguments.
+ */
+static void runScalingBenchmark(const char *partition, benchmarkSearch search, int repetitions) {
+    int id, numProcesses, p, r;
+    double *times;
+    double baseline = 0.0;
+    MPI_Comm comm;
+    MPI_Request request;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
+    if (repetitions < 1) {
+        repetitions = 1;
+    }
+    times = (double *) malloc(repetitions * sizeof(double));
+    if (id == 0) {
+        printf("partition,processes,threads,runs,min_secs,median_secs,max_secs,"
+               "speedup,efficiency,karp_flatt\n");
+    }
+
+    for (p = 1; ; p = 2 * p < numProcesses ? 2 * p : numProcesses) {
+        MPI_Comm_split(MPI_COMM_WORLD, id < p ? 0 : MPI_UNDEFINED, id, &comm);
+        if (comm != MPI_COMM_NULL) {
+            for (r = 0; r < BENCHMARK_WARMUPS; r++) {
+                timeSearch(comm, search);
+            }
+            for (r = 0; r < repetitions; r++) {
+                times[r] = timeSearch(comm, search);
+            }
+            MPI_Comm_free(&comm);
+        }
+        MPI_Ibarrier(MPI_COMM_WORLD, &request);    // the idle wait for the busy
+        waitIdle(&request);
+
+        if (id == 0) {
+            double median, speedup;
+            qsort(times, repetitions, sizeof(double), compareTimes);
+            median = repetitions % 2 ? times[repetitions / 2]
+                     : (times[repetitions / 2 - 1] + times[repetitions / 2]) / 2;
+            if (p == 1) {
+                baseline = median;
+            }
+            speedup = baseline / median;
+            printf("%s,%d,%d,%d,%f,%f,%f,%.3f,%.3f,", partition, p, omp_get_max_threads(),
+                   repetitions, times[0], median, times[repetitions - 1], speedup, speedup / p);
+            if (p > 1) {
+                printf("%.4f\n", (1 / speedup - 1.0 / p) / (1 - 1.0 / p));
+            } else {
+                printf("\n");    // undefined on 1 process
+            }
+            fflush(stdout);
+        }
+        if (p == numProcesses) {
+            break;
+        }
+    }
+    free(times);
+}
+
+#endif
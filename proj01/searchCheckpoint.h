@@ -0,0 +1,121 @@
+/* searchCheckpoint.h saves the progress of a long search to a file every
+ *  so often, so that a search cut short (by a time limit, or a crash)
+ *  can be resumed from where it was instead of started over.
+ *
+ * Each process's progress is a fixed number of unsigned long long words
+ *  of its own choosing (say, how many of its blocks it has checked and its
+ *  counts so far), all zeros meaning it has not started. The file holds a
+ *  header and then one record of those words per process, in process
+ *  order, so every process writes its own record with MPI_File_write_at
+ *  whenever it likes, without waiting for the others.
+ *  The header holds the number of processes and of words, and a signature
+ *  of the problem from the caller, so a checkpoint is only resumed by the
+ *  same search on the same number of processes.
+ *
+ * Usage: searchCheckpoint checkpoint;
+ *        if (!openCheckpoint(&checkpoint, fileName, signature, numWords, state))
+ *            ...  start state from scratch
+ *        while (...) {
+ *            ...  advance state
+ *            saveCheckpoint(&checkpoint, state, 0);
+ *        }
+ *        saveCheckpoint(&checkpoint, state, 1);
+ *        closeCheckpoint(&checkpoint);
+ */
+
+#ifndef SEARCH_CHECKPOINT
+#define SEARCH_CHECKPOINT
+
+#include <stdio.h>     // fprintf()
+#include <mpi.h>       // MPI functions
+
+#define CHECKPOINT_MAGIC 0x31544b4343524943ULL   // "CIRCCKT1"
+#define CHECKPOINT_SECS  60.0   // how often saveCheckpoint() writes
+
+typedef struct {
+    MPI_File file;
+    int numWords;               // in each process's record
+    MPI_Offset offset;          // of this process's record
+    double lastSave;            // MPI_Wtime() of the last save
+} searchCheckpoint;
+
+/* openCheckpoint() opens (or creates) the checkpoint file fileName.
+ * parameters: signature, a number identifying the problem;
+ *             numWords, the words of progress of each process;
+ *             state, room for them.
+ * Precondition: every process calls this, with the same arguments but state.
+ * return: 1 if fileName held a checkpoint of this search, now in state;
+ *          0 if not (state is untouched); -1 if the file cannot be opened.
+ */
+static int openCheckpoint(searchCheckpoint *checkpoint, const char *fileName,
+                          unsigned long long signature, int numWords,
+                          unsigned long long *state) {
+    int id, numProcesses, resumed;
+    unsigned long long header[4] = {0, 0, 0, 0};
+    MPI_Offset size = 0;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
+    if (MPI_File_open(MPI_COMM_WORLD, (char *) fileName, MPI_MODE_CREATE | MPI_MODE_RDWR,
+                      MPI_INFO_NULL, &checkpoint->file) != MPI_SUCCESS) {
+        if (id == 0) {
+            fprintf(stderr, "cannot open %s\n", fileName);
+        }
+        return -1;
+    }
+    checkpoint->numWords = numWords;
+    checkpoint->offset = (MPI_Offset) (4 + (long long) id * numWords) * sizeof(unsigned long long);
+    checkpoint->lastSave = MPI_Wtime();
+
+    MPI_File_get_size(checkpoint->file, &size);
+    if (size >= (MPI_Offset) (4 + (long long) numProcesses * numWords) * sizeof(unsigned long long)) {
+        MPI_File_read_at_all(checkpoint->file, 0, header, 4, MPI_UNSIGNED_LONG_LONG,
+                             MPI_STATUS_IGNORE);
+    }
+    resumed = header[0] == CHECKPOINT_MAGIC && header[1] == (unsigned long long) numProcesses
+              && header[2] == (unsigned long long) numWords && header[3] == signature;
+
+    if (resumed) {
+        MPI_File_read_at_all(checkpoint->file, checkpoint->offset, state, numWords,
+                             MPI_UNSIGNED_LONG_LONG, MPI_STATUS_IGNORE);
+    } else {
+        header[0] = CHECKPOINT_MAGIC;
+        header[1] = numProcesses;
+        header[2] = numWords;
+        header[3] = signature;
+        // no stale records; a record not yet saved reads as all zeros
+        MPI_File_set_size(checkpoint->file, 0);
+        MPI_File_set_size(checkpoint->file, (MPI_Offset) (4 + (long long) numProcesses * numWords)
+                                            * sizeof(unsigned long long));
+        if (id == 0) {
+            MPI_File_write_at(checkpoint->file, 0, header, 4, MPI_UNSIGNED_LONG_LONG,
+                              MPI_STATUS_IGNORE);
+        }
+    }
+    return resumed;
+}
+
+/* saveCheckpoint() writes this process's progress, if CHECKPOINT_SECS
+ *  have passed since it last did (or always, if force).
+ * parameters: state, its numWords words of progress.
+ */
+static void saveCheckpoint(searchCheckpoint *checkpoint, const unsigned long long *state,
+                           int force) {
+    double now = MPI_Wtime();
+
+    if (force || now - checkpoint->lastSave >= CHECKPOINT_SECS) {
+        MPI_File_write_at(checkpoint->file, checkpoint->offset, (void *) state,
+                          checkpoint->numWords, MPI_UNSIGNED_LONG_LONG, MPI_STATUS_IGNORE);
+        checkpoint->lastSave = now;
+    }
+}
+
+/* closeCheckpoint() flushes and closes the checkpoint file.
+ * Precondition: every process calls this, after its last save.
+ */
+static void closeCheckpoint(searchCheckpoint *checkpoint) {
+    MPI_File_sync(checkpoint->file);
+    MPI_File_close(&checkpoint->file);
+}
+
+#endif
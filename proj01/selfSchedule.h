@@ -0,0 +1,110 @@
+/* selfSchedule.h hands out the iterations 0 .. total-1 of a loop to
+ *  whichever process asks next, so faster processes simply do more.
+ *
+ * The iterations are cut into a guided schedule: chunk k takes
+ *  max(minChunk, remaining / (2 * numProcesses)) of the iterations the
+ *  earlier chunks left, so chunks start large (little overhead) and end
+ *  small (little waiting at the end). Every process computes the same
+ *  cut; the only shared state is the number of the next chunk, a counter
+ *  in an MPI window on process 0 that processes advance with
+ *  MPI_Fetch_and_op, without process 0 having to answer.
+ *
+ * Usage: selfSchedule schedule;
+ *        createSelfSchedule(&schedule, total, minChunk);
+ *        while (nextSelfScheduleChunk(&schedule, &start, &stop)) {
+ *            for (i = start; i < stop; i++) ...
+ *        }
+ *        freeSelfSchedule(&schedule);
+ */
+
+#ifndef SELF_SCHEDULE
+#define SELF_SCHEDULE
+
+#include <stdlib.h>    // malloc()
+#include <mpi.h>       // MPI functions
+
+typedef struct {
+    MPI_Win window;               // holds the next chunk number, on process 0
+    long long *next;              // that counter (process 0 only)
+    unsigned long long *bounds;   // chunk k is bounds[k] .. bounds[k+1]-1
+    long long numChunks;
+    long long chunksClaimed;      // by this process
+} selfSchedule;
+
+/* createSelfSchedule() sets up the schedule of total iterations.
+ * Precondition: every process calls this, with the same arguments.
+ */
+static void createSelfSchedule(selfSchedule *schedule, unsigned long long total,
+                               unsigned long long minChunk) {
+    int id, numProcesses;
+    unsigned long long done = 0, size;
+    long long k = 0, capacity = 64;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
+    if (minChunk < 1) {
+        minChunk = 1;
+    }
+
+    // the guided cut, the same on every process
+    schedule->bounds = (unsigned long long *) malloc(capacity * sizeof(unsigned long long));
+    schedule->bounds[0] = 0;
+    while (done < total) {
+        size = (total - done) / (2 * numProcesses);
+        if (size < minChunk) {
+            size = minChunk;
+        }
+        if (size > total - done) {
+            size = total - done;
+        }
+        done += size;
+        if (++k == capacity) {
+            capacity *= 2;
+            schedule->bounds = (unsigned long long *) realloc(schedule->bounds,
+                                                               capacity * sizeof(unsigned long long));
+        }
+        schedule->bounds[k] = done;
+    }
+    schedule->numChunks = k;
+    schedule->chunksClaimed = 0;
+
+    MPI_Win_allocate(id == 0 ? sizeof(long long) : 0, sizeof(long long), MPI_INFO_NULL,
+                     MPI_COMM_WORLD, &schedule->next, &schedule->window);
+    if (id == 0) {
+        *schedule->next = 0;
+    }
+    MPI_Barrier(MPI_COMM_WORLD);    // the counter is 0 before anyone claims
+    MPI_Win_lock_all(0, schedule->window);
+}
+
+/* nextSelfScheduleChunk() claims the next unclaimed chunk.
+ * Postcondition: if a chunk was left, this process owns the iterations
+ *                 *start .. *stop-1, and no other process does.
+ * return: 1 if a chunk was claimed; 0 once every chunk is taken.
+ */
+static int nextSelfScheduleChunk(selfSchedule *schedule, unsigned long long *start,
+                                 unsigned long long *stop) {
+    const long long one = 1;
+    long long ticket;
+
+    MPI_Fetch_and_op(&one, &ticket, MPI_LONG_LONG, 0, 0, MPI_SUM, schedule->window);
+    MPI_Win_flush(0, schedule->window);
+    if (ticket >= schedule->numChunks) {
+        return 0;
+    }
+    *start = schedule->bounds[ticket];
+    *stop = schedule->bounds[ticket + 1];
+    schedule->chunksClaimed++;
+    return 1;
+}
+
+/* freeSelfSchedule() releases the window.
+ * Precondition: every process calls this, after its last claim.
+ */
+static void freeSelfSchedule(selfSchedule *schedule) {
+    MPI_Win_unlock_all(schedule->window);
+    MPI_Win_free(&schedule->window);
+    free(schedule->bounds);
+}
+
+#endif
@@ -0,0 +1,191 @@
+/* solutionBuffer.h collects the solutions a process finds into a compact
+ *  buffer of uint32_t inputs, so the timed search never touches stdout.
+ *
+ * After the search, the buffers can be
+ *  - gathered onto process 0 with MPI_Gatherv (gatherSolutionBuffer()),
+ *     and printed there in the format checkCircuitBits() used
+ *     (printSolutionBuffer()), or
+ *  - written in parallel to one binary file of uint32_t, in process
+ *     order, with MPI-IO (writeSolutionFile()).
+ *
+ * Usage: solutionBuffer buffer = {NULL, 0, 0};
+ *        ...  appendSolutionLanes(&buffer, base, evaluateCircuitBits(base));
+ *        ...  (the search is over)
+ *        keepFirstSolutions(&buffer, wanted);    (a search for the first few only)
+ *        reportSolutions(&buffer, fileName, printThem);
+ */
+
+#ifndef SOLUTION_BUFFER
+#define SOLUTION_BUFFER
+
+#include <stdio.h>     // fprintf()
+#include <stdlib.h>    // realloc()
+#include <stdint.h>    // uint32_t
+#include <mpi.h>       // MPI functions
+#include "checkCircuitBits.h" // circuitLanes, printCircuitInput()
+
+typedef struct {
+    uint32_t *values;
+    long count, capacity;
+} solutionBuffer;
+
+/* appendSolutionLanes() adds the inputs base+k of every lane k set in solutions.
+ */
+static inline void appendSolutionLanes(solutionBuffer *buffer, unsigned long base,
+                                       circuitLanes solutions) {
+    for (; solutions; solutions &= solutions - 1) {
+        if (buffer->count == buffer->capacity) {
+            buffer->capacity = buffer->capacity ? 2 * buffer->capacity : 1024;
+            buffer->values = (uint32_t *) realloc(buffer->values,
+                                                   buffer->capacity * sizeof(uint32_t));
+            if (buffer->values == NULL) {
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+        }
+        buffer->values[buffer->count++] = (uint32_t) (base + __builtin_ctzll(solutions));
+    }
+}
+
+/* gatherSolutionBuffer() collects every process's buffer onto process 0.
+ * parameters: buffer, this process's solutions;
+ *             owners, NULL, or on process 0 room for one int per process.
+ * Postcondition: on process 0, buffer holds all the solutions in process
+ *                 order, and owners[p] how many of them came from process p.
+ */
+static void gatherSolutionBuffer(solutionBuffer *buffer, int *owners) {
+    int id, numProcesses, p;
+    int count = (int) buffer->count;
+    int *counts = NULL, *displs = NULL;
+    solutionBuffer all = {NULL, 0, 0};
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
+    if (id == 0) {
+        counts = owners ? owners : (int *) malloc(numProcesses * sizeof(int));
+        displs = (int *) malloc(numProcesses * sizeof(int));
+    }
+    MPI_Gather(&count, 1, MPI_INT, counts, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (id == 0) {
+        for (p = 0; p < numProcesses; p++) {
+            displs[p] = (int) all.count;
+            all.count += counts[p];
+        }
+        all.capacity = all.count;
+        all.values = (uint32_t *) malloc((all.count + 1) * sizeof(uint32_t));
+    }
+    MPI_Gatherv(buffer->values, count, MPI_UINT32_T,
+                all.values, counts, displs, MPI_UINT32_T, 0, MPI_COMM_WORLD);
+    if (id == 0) {
+        free(buffer->values);
+        *buffer = all;
+        if (counts != owners) {
+            free(counts);
+        }
+        free(displs);
+    }
+}
+
+/* printSolutionBuffer() prints gathered solutions as checkCircuitBits() did,
+ *  each tagged with the id of the process that found it.
+ * Precondition: buffer and owners come from gatherSolutionBuffer().
+ */
+static void printSolutionBuffer(const solutionBuffer *buffer, const int *owners) {
+    long i = 0;
+    int p = 0, left = owners[0];
+
+    for (i = 0; i < buffer->count; i++) {
+        while (left == 0) {
+            left = owners[++p];
+        }
+        printCircuitInput(p, buffer->values[i]);
+        left--;
+    }
+}
+
+/* writeSolutionFile() writes every process's solutions to one binary file
+ *  of uint32_t, process 0's first, each process writing its own part.
+ * Precondition: every process calls this with the same fileName.
+ * return: 1 on success; 0 (after process 0 says why) otherwise.
+ */
+static int writeSolutionFile(const char *fileName, const solutionBuffer *buffer) {
+    int id;
+    long long count = buffer->count, before = 0;
+    MPI_File file;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Exscan(&count, &before, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (id == 0) {
+        before = 0;    // MPI_Exscan leaves process 0's result undefined
+    }
+
+    if (MPI_File_open(MPI_COMM_WORLD, (char *) fileName, MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                      MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+        if (id == 0) {
+            fprintf(stderr, "cannot write %s\n", fileName);
+        }
+        return 0;
+    }
+    MPI_File_set_size(file, 0);
+    MPI_File_write_at_all(file, before * sizeof(uint32_t), buffer->values, (int) count,
+                          MPI_UINT32_T, MPI_STATUS_IGNORE);
+    MPI_File_close(&file);
+    return 1;
+}
+
+// orders uint32_t solutions for qsort()
+static int compareSolutions(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+    return (x > y) - (x < y);
+}
+
+/* keepFirstSolutions() trims the search's solutions to the first wanted of
+ *  them, in the order gatherSolutionBuffer() puts them: each process's in
+ *  increasing order, process 0's first.
+ * Precondition: every process calls this, after the search.
+ * return: the solutions this process keeps.
+ */
+static long keepFirstSolutions(solutionBuffer *buffer, long long wanted) {
+    int id;
+    long long count = buffer->count, before = 0;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    qsort(buffer->values, buffer->count, sizeof(uint32_t), compareSolutions);
+    MPI_Exscan(&count, &before, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (id == 0) {
+        before = 0;    // MPI_Exscan leaves process 0's result undefined
+    }
+    if (before + count > wanted) {
+        buffer->count = before < wanted ? (long) (wanted - before) : 0;
+    }
+    return buffer->count;
+}
+
+/* reportSolutions() is the post-processing step of a search: it writes
+ *  the solutions to fileName (unless NULL) and then, if printThem,
+ *  prints them on process 0.  Each process's solutions come out in
+ *  increasing order, however its threads found them.
+ * Precondition: every process calls this, after the timed search.
+ */
+static void reportSolutions(solutionBuffer *buffer, const char *fileName, int printThem) {
+    int id, numProcesses;
+    int *owners = NULL;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
+    qsort(buffer->values, buffer->count, sizeof(uint32_t), compareSolutions);
+    if (fileName) {
+        writeSolutionFile(fileName, buffer);
+    }
+    if (printThem) {
+        if (id == 0) {
+            owners = (int *) malloc(numProcesses * sizeof(int));
+        }
+        gatherSolutionBuffer(buffer, owners);
+        if (id == 0) {
+            printSolutionBuffer(buffer, owners);
+            free(owners);
+        }
+    }
+}
+
+#endif
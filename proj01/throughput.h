@@ -0,0 +1,44 @@
+/* throughput.h reports how fast each process of a search went, to show
+ *  how evenly the work (and the machine) was shared.
+ *
+ * Usage: double seconds = MPI_Wtime();
+ *        ...  the search: this process checks items inputs in chunks pieces
+ *        reportThroughput(MPI_Wtime() - seconds, items, chunks);
+ */
+
+#ifndef THROUGHPUT
+#define THROUGHPUT
+
+#include <stdio.h>     // printf()
+#include <stdlib.h>    // malloc()
+#include <mpi.h>       // MPI functions
+
+/* reportThroughput() prints, on process 0, how much of the work each
+ *  process did and how fast.
+ * parameters: seconds, this process's time in the search loop;
+ *             items, the candidates it checked;
+ *             chunks, the chunks it took (1 for a static split).
+ * Precondition: every process calls this.
+ */
+static void reportThroughput(double seconds, unsigned long long items, long long chunks) {
+    int id, numProcesses, p;
+    double mine[3] = {seconds, (double) items, (double) chunks};
+    double *all = NULL;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
+    if (id == 0) {
+        all = (double *) malloc(3 * numProcesses * sizeof(double));
+    }
+    MPI_Gather(mine, 3, MPI_DOUBLE, all, 3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (id == 0) {
+        for (p = 0; p < numProcesses; p++) {
+            double *r = &all[3 * p];
+            printf("Process %d checked %.0f inputs in %.0f chunks, %f secs, %.3g inputs/sec\n",
+                   p, r[1], r[2], r[0], r[0] > 0 ? r[1] / r[0] : 0.0);
+        }
+        free(all);
+    }
+}
+
+#endif
@@ -0,0 +1,405 @@
+/* ringBenchmark.c
+ *
+ * A communication benchmark built on the ring of ringMessagePassing.c:
+ * instead of timing one pass of one short message, it times many passes
+ * (after a few untimed warm-up ones) of messages from 8 bytes to 64 MiB,
+ * and prints latency and bandwidth tables for
+ *  - ping-pong between process 0 and the first process on its own node
+ *     (intra-node) and on another node (inter-node), and
+ *  - a ring shift, in which every process sends to the next one and
+ *     receives from the one before, all at once,
+ * each done three ways: blocking (MPI_Send/MPI_Recv, MPI_Sendrecv for the
+ * ring), nonblocking (MPI_Isend/MPI_Irecv), and with persistent requests
+ * (MPI_Send_init/MPI_Recv_init, started every iteration).
+ *
+ * Last, it times a message going from process 0 all the way around the
+ * ring, as ringMessagePassing.c does, both store-and-forward (each
+ * process receives all of it before passing it on, so P hops cost about
+ * P * M / bandwidth) and pipelined, cut into segments that each process
+ * forwards while it receives the next (about (P + M/S) * S / bandwidth
+ * for segments of S bytes), and reports the size from which the
+ * pipelined pass is faster.
+ *
+ * Which processes share a node is up to mpirun; script_bench_2_2.slurm
+ * places two processes on each of two nodes, so both ping-pongs run.
+ *
+ * Usage: mpirun -np N ./ringBenchmark [-n maxBytes] [-s segmentBytes]
+ *   -n  the largest message (default 64 MiB)
+ *   -s  the segment size of the pipelined ring pass (default 64 KiB)
+ *
+ * Author: Yuese Li
+ * Institution: Calvin University
+ * Course: CS374 (High Performance Computing)
+ * Date: November 6, 2023
+ * Purpose: To characterize the interconnect that the other programs use.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+
+#define MIN_BYTES      8L
+#define MAX_BYTES      (64L << 20)
+#define TEST_BYTES     (1L << 28)   // about this many bytes moved per row...
+#define MIN_ITERATIONS 5            // ... but at least this many iterations
+#define MAX_ITERATIONS 1000         // and at most this many
+#define SEGMENT_BYTES  (64L << 10)  // of the pipelined ring pass
+
+enum { BLOCKING, NONBLOCKING, PERSISTENT, NUM_METHODS };
+static const char *methodName[NUM_METHODS] = {"blocking", "Isend/Irecv", "persistent"};
+
+/* iterationsFor() picks how many times to send a message of bytes,
+ *  enough to time small messages well and few enough for big ones.
+ */
+int iterationsFor(long bytes) {
+    long iterations = TEST_BYTES / bytes;
+
+    if (iterations < MIN_ITERATIONS) {
+        return MIN_ITERATIONS;
+    }
+    return iterations > MAX_ITERATIONS ? MAX_ITERATIONS : (int) iterations;
+}
+
+/* findNodes() finds the node of every process.
+ * Postcondition: nodeOf[r] is the lowest rank on the node of rank r.
+ */
+void findNodes(int rank, int *nodeOf) {
+    MPI_Comm nodeComm;
+    int leader = rank;
+
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &nodeComm);
+    MPI_Bcast(&leader, 1, MPI_INT, 0, nodeComm);    // rank 0 of nodeComm is the lowest
+    MPI_Comm_free(&nodeComm);
+    MPI_Allgather(&leader, 1, MPI_INT, nodeOf, 1, MPI_INT, MPI_COMM_WORLD);
+}
+
+/* pingPong() bounces a message of bytes between this process and other.
+ * parameters: method, how to send it;
+ *             starts, whether this process sends first;
+ *             out, in, buffers of at least bytes.
+ * Precondition: other calls this too, with the same arguments but starts.
+ * return: the seconds per round trip.
+ */
+double pingPong(int method, int other, int starts, char *out, char *in,
+                long bytes, int iterations) {
+    MPI_Request requests[2];    // send, receive
+    double seconds = 0.0;
+    int i;
+
+    if (method == PERSISTENT) {
+        MPI_Send_init(out, (int) bytes, MPI_CHAR, other, 0, MPI_COMM_WORLD, &requests[0]);
+        MPI_Recv_init(in, (int) bytes, MPI_CHAR, other, 0, MPI_COMM_WORLD, &requests[1]);
+    }
+    for (i = -(iterations / 10 + 1); i < iterations; i++) {    // warm-ups first
+        if (i == 0) {
+            MPI_Barrier(MPI_COMM_WORLD);
+            seconds = MPI_Wtime();
+        }
+        if (method == BLOCKING) {
+            if (starts) {
+                MPI_Send(out, (int) bytes, MPI_CHAR, other, 0, MPI_COMM_WORLD);
+                MPI_Recv(in, (int) bytes, MPI_CHAR, other, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            } else {
+                MPI_Recv(in, (int) bytes, MPI_CHAR, other, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                MPI_Send(out, (int) bytes, MPI_CHAR, other, 0, MPI_COMM_WORLD);
+            }
+        } else {
+            // post the receive before sending, so the message never waits for it
+            if (method == NONBLOCKING) {
+                MPI_Irecv(in, (int) bytes, MPI_CHAR, other, 0, MPI_COMM_WORLD, &requests[1]);
+            } else {
+                MPI_Start(&requests[1]);
+            }
+            if (!starts) {
+                MPI_Wait(&requests[1], MPI_STATUS_IGNORE);
+            }
+            if (method == NONBLOCKING) {
+                MPI_Isend(out, (int) bytes, MPI_CHAR, other, 0, MPI_COMM_WORLD, &requests[0]);
+            } else {
+                MPI_Start(&requests[0]);
+            }
+            MPI_Wait(&requests[0], MPI_STATUS_IGNORE);
+            if (starts) {
+                MPI_Wait(&requests[1], MPI_STATUS_IGNORE);
+            }
+        }
+    }
+    seconds = MPI_Wtime() - seconds;
+    if (method == PERSISTENT) {
+        MPI_Request_free(&requests[0]);
+        MPI_Request_free(&requests[1]);
+    }
+    return seconds / iterations;
+}
+
+/* ringShift() has every process send a message of bytes to the next
+ *  process and receive one from the previous, iterations times.
+ * Precondition: every process calls this, with the same arguments.
+ * return: on process 0, the seconds per shift of the slowest process.
+ */
+double ringShift(int method, int rank, int size, char *out, char *in,
+                 long bytes, int iterations) {
+    int next = (rank + 1) % size, previous = (rank + size - 1) % size;
+    MPI_Request requests[2];
+    double seconds = 0.0, slowest = 0.0;
+    int i;
+
+    if (method == PERSISTENT) {
+        MPI_Recv_init(in, (int) bytes, MPI_CHAR, previous, 0, MPI_COMM_WORLD, &requests[0]);
+        MPI_Send_init(out, (int) bytes, MPI_CHAR, next, 0, MPI_COMM_WORLD, &requests[1]);
+    }
+    for (i = -(iterations / 10 + 1); i < iterations; i++) {
+        if (i == 0) {
+            MPI_Barrier(MPI_COMM_WORLD);
+            seconds = MPI_Wtime();
+        }
+        if (method == BLOCKING) {
+            MPI_Sendrecv(out, (int) bytes, MPI_CHAR, next, 0, in, (int) bytes, MPI_CHAR,
+                         previous, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        } else {
+            if (method == NONBLOCKING) {
+                MPI_Irecv(in, (int) bytes, MPI_CHAR, previous, 0, MPI_COMM_WORLD, &requests[0]);
+                MPI_Isend(out, (int) bytes, MPI_CHAR, next, 0, MPI_COMM_WORLD, &requests[1]);
+            } else {
+                MPI_Startall(2, requests);
+            }
+            MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+        }
+    }
+    seconds = MPI_Wtime() - seconds;
+    if (method == PERSISTENT) {
+        MPI_Request_free(&requests[0]);
+        MPI_Request_free(&requests[1]);
+    }
+    MPI_Reduce(&seconds, &slowest, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    return slowest / iterations;
+}
+
+/* passOnce() sends a message of bytes from process 0 around the ring and
+ *  back to it, in numSegments segments of segment bytes (the last maybe
+ *  shorter). Every process forwards segment k as soon as it has it, while
+ *  segment k+1 is arriving; a segment stays in its place in the message,
+ *  so the two segments in flight are each other's double buffer.
+ * parameters: out, the message (process 0);
+ *             in, where it arrives;
+ *             receives, room for numSegments requests (process 0).
+ */
+void passOnce(int rank, int size, char *out, char *in, long bytes, long segment,
+              long numSegments, MPI_Request *receives) {
+    int next = (rank + 1) % size, previous = (rank + size - 1) % size;
+    MPI_Request arriving[2], sends[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+    char *from = rank == 0 ? out : in;    // what this process forwards
+    long k;
+
+#define SEGMENT_LENGTH(k) ((int) ((k) == numSegments - 1 ? bytes - (k) * segment : segment))
+
+    if (rank == 0) {
+        // the message comes back while process 0 is still sending it
+        for (k = 0; k < numSegments; k++) {
+            MPI_Irecv(in + k * segment, SEGMENT_LENGTH(k), MPI_CHAR, previous, 0,
+                      MPI_COMM_WORLD, &receives[k]);
+        }
+    } else {
+        MPI_Irecv(in, SEGMENT_LENGTH(0), MPI_CHAR, previous, 0, MPI_COMM_WORLD, &arriving[0]);
+    }
+    for (k = 0; k < numSegments; k++) {
+        if (rank != 0) {
+            if (k + 1 < numSegments) {
+                MPI_Irecv(in + (k + 1) * segment, SEGMENT_LENGTH(k + 1), MPI_CHAR, previous, 0,
+                          MPI_COMM_WORLD, &arriving[(k + 1) % 2]);
+            }
+            MPI_Wait(&arriving[k % 2], MPI_STATUS_IGNORE);
+        }
+        MPI_Wait(&sends[k % 2], MPI_STATUS_IGNORE);    // segment k-2 is gone
+        MPI_Isend(from + k * segment, SEGMENT_LENGTH(k), MPI_CHAR, next, 0,
+                  MPI_COMM_WORLD, &sends[k % 2]);
+    }
+    MPI_Waitall(2, sends, MPI_STATUSES_IGNORE);
+    if (rank == 0) {
+        MPI_Waitall((int) numSegments, receives, MPI_STATUSES_IGNORE);
+    }
+
+#undef SEGMENT_LENGTH
+}
+
+/* ringPass() times passOnce(), iterations times after some warm-ups.
+ * parameters: segment, the segment size, or 0 for store-and-forward.
+ * Precondition: every process calls this, with the same arguments.
+ * return: on process 0, the seconds per pass.
+ */
+double ringPass(long segment, int rank, int size, char *out, char *in,
+                long bytes, int iterations) {
+    long numSegments;
+    MPI_Request *receives = NULL;
+    double seconds = 0.0, start;
+    int i;
+
+    if (segment <= 0 || segment > bytes) {
+        segment = bytes;    // one segment: store-and-forward
+    }
+    numSegments = (bytes + segment - 1) / segment;
+    if (rank == 0) {
+        receives = (MPI_Request*)malloc(numSegments * sizeof(MPI_Request));
+    }
+    for (i = -(iterations / 10 + 1); i < iterations; i++) {
+        MPI_Barrier(MPI_COMM_WORLD);    // one pass at a time
+        start = MPI_Wtime();
+        passOnce(rank, size, out, in, bytes, segment, numSegments, receives);
+        if (i >= 0) {
+            seconds += MPI_Wtime() - start;
+        }
+    }
+    free(receives);
+    return seconds / iterations;
+}
+
+/* printHeading() starts a table, on process 0.
+ */
+void printHeading(const char *title, int method) {
+    printf("\n# %s, %s\n", title, methodName[method]);
+    printf("# %12s %10s %14s %16s\n", "bytes", "iterations", "latency(us)", "bandwidth(MB/s)");
+}
+
+void printRow(long bytes, int iterations, double seconds) {
+    printf("  %12ld %10d %14.2f %16.1f\n", bytes, iterations, seconds * 1e6, bytes / seconds / 1e6);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    int rank, size;
+    int *nodeOf;                 // the lowest rank on each process's node
+    int partner[2] = {-1, -1};   // of process 0: on its node, on another node
+    const char *placement[2] = {"intra-node", "inter-node"};
+    long maxBytes = MAX_BYTES, bytes;
+    long segment = SEGMENT_BYTES;
+    long crossover = -1;         // where pipelining starts to win for good
+    char *out, *in, title[80];
+    int method, where, r, crossings = 0, numNodes = 0;
+
+    // Initialize MPI
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    for (r = 1; r < argc; r++) {
+        if (strcmp(argv[r], "-n") == 0 && r + 1 < argc) {
+            maxBytes = atol(argv[++r]);
+        } else if (strcmp(argv[r], "-s") == 0 && r + 1 < argc) {
+            segment = atol(argv[++r]);
+        }
+    }
+    if (maxBytes < MIN_BYTES) {
+        maxBytes = MIN_BYTES;
+    }
+
+    // Send and receive buffers, touched so the first timed pass is not paging them in
+    out = (char*)malloc(maxBytes);
+    in = (char*)malloc(maxBytes);
+    nodeOf = (int*)malloc(size * sizeof(int));
+    if (out == NULL || in == NULL || nodeOf == NULL) {
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    memset(out, rank, maxBytes);
+    memset(in, 0, maxBytes);
+
+    // Where everyone is
+    findNodes(rank, nodeOf);
+    for (r = size - 1; r > 0; r--) {
+        partner[nodeOf[r] != nodeOf[0]] = r;    // the lowest such rank wins
+    }
+    for (r = 0; r < size; r++) {
+        crossings += nodeOf[r] != nodeOf[(r + 1) % size];
+        numNodes += nodeOf[r] == r;
+    }
+    if (rank == 0) {
+        printf("%d processes on %d node(s)\n", size, numNodes);
+    }
+
+    // Ping-pong, with a process on the same node and then with one on another
+    for (where = 0; where < 2; where++) {
+        if (partner[where] < 0) {
+            if (rank == 0) {
+                printf("\n# ping-pong, %s: no process to pair with\n", placement[where]);
+            }
+            continue;
+        }
+        for (method = 0; method < NUM_METHODS; method++) {
+            if (rank == 0) {
+                sprintf(title, "ping-pong, %s (ranks 0 and %d)", placement[where], partner[where]);
+                printHeading(title, method);
+            }
+            for (bytes = MIN_BYTES; bytes <= maxBytes; bytes *= 2) {
+                int iterations = iterationsFor(bytes);
+                double seconds = 0.0;
+                if (rank == 0 || rank == partner[where]) {
+                    seconds = pingPong(method, rank == 0 ? partner[where] : 0, rank == 0,
+                                       out, in, bytes, iterations);
+                } else {
+                    MPI_Barrier(MPI_COMM_WORLD);    // the one pingPong() starts its timing with
+                }
+                if (rank == 0) {
+                    printRow(bytes, iterations, seconds / 2);    // one way
+                }
+            }
+        }
+    }
+
+    // Ring shift, every link busy at once
+    for (method = 0; method < NUM_METHODS && size > 1; method++) {
+        if (rank == 0) {
+            sprintf(title, "ring shift, %d processes, %d of %d links between nodes",
+                    size, crossings, size);
+            printHeading(title, method);
+        }
+        for (bytes = MIN_BYTES; bytes <= maxBytes; bytes *= 2) {
+            int iterations = iterationsFor(bytes);
+            double seconds = ringShift(method, rank, size, out, in, bytes, iterations);
+            if (rank == 0) {
+                printRow(bytes, iterations, seconds);    // per link
+            }
+        }
+    }
+
+    // The whole message around the ring, store-and-forward vs. pipelined
+    if (size > 1) {
+        if (rank == 0) {
+            printf("\n# ring pass, %d processes, store-and-forward vs. %ld-byte segments\n",
+                   size, segment);
+            printf("# %12s %10s %18s %14s %8s\n", "bytes", "iterations",
+                   "store-forward(us)", "pipelined(us)", "speedup");
+        }
+        for (bytes = MIN_BYTES; bytes <= maxBytes; bytes *= 2) {
+            int iterations = iterationsFor(bytes);
+            double whole = ringPass(0, rank, size, out, in, bytes, iterations);
+            double pipelined = ringPass(segment, rank, size, out, in, bytes, iterations);
+            if (rank == 0) {
+                printf("  %12ld %10d %18.2f %14.2f %8.2f\n", bytes, iterations,
+                       whole * 1e6, pipelined * 1e6, whole / pipelined);
+                fflush(stdout);
+                if (bytes <= segment) {
+                    // one segment either way: the same pass
+                } else if (pipelined >= whole) {
+                    crossover = -1;
+                } else if (crossover < 0) {
+                    crossover = bytes;
+                }
+            }
+        }
+        if (rank == 0) {
+            if (crossover > 0) {
+                printf("# pipelining wins from %ld bytes up\n", crossover);
+            } else {
+                printf("# pipelining never won for good, up to %ld bytes\n", maxBytes);
+            }
+        }
+    }
+
+    // Clean up and finalize MPI
+    free(out);
+    free(in);
+    free(nodeOf);
+    MPI_Finalize();
+
+    return 0;
+}
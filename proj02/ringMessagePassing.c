@@ -5,6 +5,10 @@
  * and passes it to the next process. The master process starts the timer, initiates the message passing, 
  * and calculates the time taken for the message to traverse the entire ring once it's received back from the last process.
  *
+ * The message is an array of ints, the ranks it has visited, received in place into a buffer with room
+ * for all of them; its length is the fill count, so a hop just stores one int and sends one int more.
+ * It is turned into text only once it is back at the master, after the timing.
+ *
  * Author: Yuese Li
  * Institution: Calvin University
  * Course: CS374 (High Performance Computing)
@@ -16,24 +20,21 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
 #include <mpi.h>
 
 int main(int argc, char** argv) {
     int rank, size;
     MPI_Status status;
     double startTime, endTime;
+    int count;                  // ranks in the message so far
 
     // Initialize MPI
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    // The buffer size is large enough to hold a message with all ranks
-    // Each rank needs up to 3 characters, plus a space, plus 1 for the null terminator
-    int bufferSize = (3 + 1) * size + 1;
-    char *message = (char*)malloc(bufferSize);
-    memset(message, 0, bufferSize);
+    // The buffer is large enough to hold a message with all ranks
+    int *ranks = (int*)malloc(size * sizeof(int));
 
     // Master process
     if (rank == 0) {
@@ -41,38 +42,40 @@ int main(int argc, char** argv) {
         startTime = MPI_Wtime();
 
         // Create a message containing its rank
-        sprintf(message, "%d", rank);
+        ranks[0] = rank;
 
         // Send that message to the next process (rank 1)
-        MPI_Send(message, strlen(message) + 1, MPI_CHAR, 1, 0, MPI_COMM_WORLD);
+        MPI_Send(ranks, 1, MPI_INT, 1, 0, MPI_COMM_WORLD);
 
         // Receive a message from the last worker (rank n-1)
-        MPI_Recv(message, bufferSize, MPI_CHAR, size - 1, 0, MPI_COMM_WORLD, &status);
+        MPI_Recv(ranks, size, MPI_INT, size - 1, 0, MPI_COMM_WORLD, &status);
+        MPI_Get_count(&status, MPI_INT, &count);
 
-        // Calculate the end time and print the results
+        // Calculate the end time, then print the results
         endTime = MPI_Wtime();
-        printf("%s\n", message);
+        for (int i = 0; i < count; i++) {
+            printf(i ? " %d" : "%d", ranks[i]);
+        }
+        printf("\n");
         printf("time: %f secs\n", endTime - startTime);
     }
     // Worker process
     else {
         // Receive a message from the process before it in the ring
-        MPI_Recv(message, bufferSize, MPI_CHAR, rank - 1, 0, MPI_COMM_WORLD, &status);
+        MPI_Recv(ranks, size, MPI_INT, rank - 1, 0, MPI_COMM_WORLD, &status);
+        MPI_Get_count(&status, MPI_INT, &count);
 
         // Append its own rank to the message
-        // Buffer size adjusted to hold up to a 3-digit number, a space, and a null terminator
-        char newMessage[5];
-        sprintf(newMessage, " %d", rank);
-        strcat(message, newMessage);
+        ranks[count++] = rank;
 
         // Send the new message to the next process in the ring
         int nextRank = (rank + 1) % size;
-        MPI_Send(message, strlen(message) + 1, MPI_CHAR, nextRank, 0, MPI_COMM_WORLD);
+        MPI_Send(ranks, count, MPI_INT, nextRank, 0, MPI_COMM_WORLD);
     }
 
     // Clean up and finalize MPI
-    free(message);
+    free(ranks);
     MPI_Finalize();
 
     return 0;
-}
\ No newline at end of file
+}
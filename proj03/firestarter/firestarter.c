@@ -1,11 +1,42 @@
 /* firestarter.c
  * David Joiner
- * Usage: Fire [forestSize(20)] [numTrials(5000)] * [numProbabilities(101)] [showGraph(1)]
+ * Usage: Fire [options] [forestSize(80)] [numTrials(5000)] [numProbabilities(101)] [showGraph(0)]
+ *
+ *  -m trials|domain    trials (default): average numTrials small fires for each of
+ *                       numProbabilities spread probabilities;
+ *                      domain: burn one forestSize x forestSize forest,
+ *                       split across all processes
+ *  -n forestSize       trees per side of the forest
+ *  -t numTrials        trials per probability
+ *  -p min[:max]        spread probability, or range of them (default 0:1, domain 0.6)
+ *  -k numProbabilities points in the probability range
+ *  -i row,col          tree to light first (default: the center)
+ *  -N 4|8              fire spreads to the 4 or 8 nearest trees
+ *  -e bits|scalar      trial engine: 64 trials per word (default), or one at a time
+ *  -s cyclic|block     how trial batches are dealt to processes (default cyclic)
+ *  -o csvFile -b snapshotFile -l progressLog -g -r reportRounds(10) -R snapshotFile
+ *                      results sinks: see forestResults.h
+ *  -c checkpointFile   checkpoint every -C rounds(50), and restart from the
+ *                       file if it holds a checkpoint of this same run
+ *  -S seed             seed the random streams (default: the time); with the
+ *                       same seed and process count a run, interrupted and
+ *                       restarted or not, always gives the same results
+ *
+ * The positional arguments are the ones this program has always advertised;
+ *  options and positionals can be mixed.
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
 #include <mpi.h>
 #include "X-graph.h"
+#include "forestBits.h"
+#include "forestDomain.h"
+#include "forestResults.h"
+#include "forestCheckpoint.h"
+#include "forestRandom.h"
 
 #define UNBURNT 0
 #define SMOLDERING 1
@@ -14,17 +45,43 @@
 
 typedef int boolean;
 
-extern void seed_by_time(int);
+extern void seed_scalar_forest(uint64_t);
 extern int **allocate_forest(int);
 extern void initialize_forest(int, int **);
 extern double get_percent_burned(int, int **);
 extern void delete_forest(int, int **);
 extern void light_tree(int, int **, int, int);
 extern boolean forest_is_burning(int, int **);
-extern void forest_burns(int, int **, double);
-extern int burn_until_out(int, int **, double, int, int);
+extern void forest_burns(int, int **, double, int);
+extern uint64_t scalar_rng;
+extern int burn_until_out(int, int **, double, int, int, int);
 extern void print_forest(int, int **);
 
+// Everything the command line can set
+typedef struct fire_options_mem {
+    int domain_mode;
+    long forest_size;
+    long n_trials;
+    double prob_min, prob_max;
+    int n_probs;
+    int prob_given;
+    long start_i, start_j;       // -1: the center
+    int neighborhood;            // 4 or 8
+    int bit_engine;
+    int block_schedule;
+    const char *csv_name, *binary_name, *progress_name, *resume_name;
+    int report_rounds;
+    int show_graph;
+    const char *checkpoint_name;
+    int checkpoint_rounds;
+    int seed_given;
+    uint64_t seed;
+} fire_options;
+
+static int parse_options(int argc, char **argv, fire_options *options);
+static void run_trials(int id, int numProcesses, fire_options *options);
+static void burn_one_large_forest(int id, int numProcesses, fire_options *options);
+
 int main(int argc, char **argv)
 {
     // Initialize MPI
@@ -33,13 +90,194 @@ int main(int argc, char **argv)
     MPI_Comm_rank(MPI_COMM_WORLD, &id);
     MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
 
+    fire_options options;
+    if (!parse_options(argc, argv, &options))
+    {
+        if (id == 0)
+        {
+            fprintf(stderr, "Usage: %s [-m trials|domain] [-n forestSize] [-t numTrials] [-p min[:max]]\n"
+                            "          [-k numProbabilities] [-i row,col] [-N 4|8] [-e bits|scalar]\n"
+                            "          [-s cyclic|block] [-o csvFile] [-b snapshotFile] [-l progressLog]\n"
+                            "          [-r reportRounds] [-R snapshotFile] [-g]\n"
+                            "          [-c checkpointFile] [-C checkpointRounds] [-S seed]\n"
+                            "          [forestSize] [numTrials] [numProbabilities] [showGraph]\n",
+                    argv[0]);
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
+    if (options.domain_mode)
+    {
+        burn_one_large_forest(id, numProcesses, &options);
+    }
+    else
+    {
+        run_trials(id, numProcesses, &options);
+    }
+
+    // Finalize MPI
+    MPI_Finalize();
+    return 0;
+}
+
+/* fill options from the command line
+ * @return: true iff the command line made sense.
+ */
+static int parse_options(int argc, char **argv, fire_options *options)
+{
+    int opt, k_given = 0;
+
+    memset(options, 0, sizeof(fire_options));
+    options->forest_size = 80;
+    options->n_trials = 5000;
+    options->prob_min = 0.0;
+    options->prob_max = 1.0;
+    options->n_probs = 101;
+    options->start_i = options->start_j = -1;
+    options->neighborhood = 4;
+    options->bit_engine = 1;
+    options->report_rounds = 10;
+    options->checkpoint_rounds = 50;
+
+    while ((opt = getopt(argc, argv, "m:n:t:p:k:i:N:e:s:o:b:l:r:R:gc:C:S:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'm':
+            if (strcmp(optarg, "domain") != 0 && strcmp(optarg, "trials") != 0)
+                return 0;
+            options->domain_mode = strcmp(optarg, "domain") == 0;
+            break;
+        case 'n':
+            options->forest_size = strtol(optarg, NULL, 10);
+            break;
+        case 't':
+            options->n_trials = strtol(optarg, NULL, 10);
+            break;
+        case 'p':
+            if (sscanf(optarg, "%lf:%lf", &options->prob_min, &options->prob_max) == 1)
+            {
+                options->prob_max = options->prob_min;
+                if (!k_given)
+                    options->n_probs = 1;
+            }
+            options->prob_given = 1;
+            break;
+        case 'k':
+            options->n_probs = atoi(optarg);
+            k_given = 1;
+            break;
+        case 'i':
+            if (sscanf(optarg, "%ld,%ld", &options->start_i, &options->start_j) != 2)
+                return 0;
+            break;
+        case 'N':
+            options->neighborhood = atoi(optarg);
+            if (options->neighborhood != 4 && options->neighborhood != 8)
+                return 0;
+            break;
+        case 'e':
+            options->bit_engine = strcmp(optarg, "scalar") != 0;
+            break;
+        case 's':
+            options->block_schedule = strcmp(optarg, "block") == 0;
+            break;
+        case 'o':
+            options->csv_name = optarg;
+            break;
+        case 'b':
+            options->binary_name = optarg;
+            break;
+        case 'l':
+            options->progress_name = optarg;
+            break;
+        case 'r':
+            options->report_rounds = atoi(optarg);
+            break;
+        case 'R':
+            options->resume_name = optarg;
+            break;
+        case 'g':
+            options->show_graph = 1;
+            break;
+        case 'c':
+            options->checkpoint_name = optarg;
+            break;
+        case 'C':
+            options->checkpoint_rounds = atoi(optarg);
+            break;
+        case 'S':
+            options->seed = strtoull(optarg, NULL, 10);
+            options->seed_given = 1;
+            break;
+        default:
+            return 0;
+        }
+    }
+
+    // Fire [forestSize] [numTrials] [numProbabilities] [showGraph]
+    if (optind < argc)
+        options->forest_size = strtol(argv[optind++], NULL, 10);
+    if (optind < argc)
+        options->n_trials = strtol(argv[optind++], NULL, 10);
+    if (optind < argc)
+        options->n_probs = atoi(argv[optind++]);
+    if (optind < argc)
+        options->show_graph = atoi(argv[optind++]) != 0;
+
+    if (options->domain_mode && !options->prob_given)
+    {
+        options->prob_min = options->prob_max = 0.6;
+    }
+    if (options->start_i < 0 || options->start_j < 0)
+    {
+        options->start_i = options->start_j = options->forest_size / 2;
+    }
+    return optind == argc && options->forest_size > 0 && options->n_trials > 0 &&
+           options->n_probs > 0 && options->checkpoint_rounds > 0 && options->start_i < options->forest_size &&
+           options->start_j < options->forest_size;
+}
+
+/* the i_round'th batch this process runs, in a sweep of n_batches
+ *  batches that starts at first_batch
+ * @return: the batch number, or -1 if this process has no batch that round.
+ */
+static long schedule_batch(fire_options *options, int id, int numProcesses,
+                           long first_batch, long n_batches, long i_round)
+{
+    long batch;
+
+    if (options->block_schedule)
+    {
+        // contiguous runs of batches, the first (remaining % P) runs one longer
+        long remaining = n_batches - first_batch;
+        long chunk = remaining / numProcesses, extra = remaining % numProcesses;
+        long count = chunk + (id < extra);
+        if (i_round >= count)
+            return -1;
+        batch = first_batch + id * chunk + (id < extra ? id : extra) + i_round;
+    }
+    else
+    {
+        batch = first_batch + i_round * numProcesses + id;
+    }
+    return batch < n_batches ? batch : -1;
+}
+
+/* average many small fires for each probability and report the curve
+ */
+static void run_trials(int id, int numProcesses, fire_options *options)
+{
     // Start timing
     double start_time = MPI_Wtime();
 
     // Initial conditions and variable definitions
-    int forest_size = 80; // Forest size
-    double prob_min = 0.0, prob_max = 1.0, prob_step;
-    int n_trials = 5000, n_probs = 101; // Number of trials and probabilities
+    int forest_size = options->forest_size;
+    double prob_min = options->prob_min, prob_max = options->prob_max, prob_step;
+    long n_trials = options->n_trials;
+    int n_probs = options->n_probs; // Number of trials and probabilities
+    int batch_trials = options->bit_engine ? BIT_LANES : 1;
 
     // Allocate memory for arrays
     double *prob_spread = (double *)malloc(n_probs * sizeof(double));
@@ -50,8 +288,8 @@ int main(int argc, char **argv)
     }
     double *local_percent_burned = (double *)calloc(n_probs, sizeof(double));
     double *global_percent_burned = (double *)calloc(n_probs, sizeof(double));
-    int *local_iterations = (int *)calloc(n_probs, sizeof(int));
-    int *global_iterations = (int *)calloc(n_probs, sizeof(int));
+    long *local_iterations = (long *)calloc(n_probs, sizeof(long));
+    long *global_iterations = (long *)calloc(n_probs, sizeof(long));
 
     // Check for allocation failures
     if (!local_percent_burned || !global_percent_burned || !local_iterations || !global_iterations)
@@ -60,26 +298,143 @@ int main(int argc, char **argv)
         MPI_Abort(MPI_COMM_WORLD, 1);
     }
 
-    // Setup problem
-    seed_by_time(id); // Unique seed for each process
-    int **forest = allocate_forest(forest_size);
-    prob_step = (prob_max - prob_min) / (double)(n_probs - 1);
+    // Every process seeds its own stream from the run's seed
+    uint64_t seed = options->seed_given ? options->seed : (uint64_t)time(NULL);
+    MPI_Bcast(&seed, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+
+    // Setup problem: one of the two engines
+    bit_forest *bits = NULL;
+    int **forest = NULL;
+    if (options->bit_engine)
+    {
+        bits = allocate_bit_forest(forest_size, options->neighborhood);
+        if (bits == NULL)
+        {
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        seed_bit_forest(bits, seed + id); // Unique seed for each process
+    }
+    else
+    {
+        forest = allocate_forest(forest_size);
+        seed_scalar_forest(seed + id); // Unique seed for each process
+    }
+    prob_step = n_probs > 1 ? (prob_max - prob_min) / (double)(n_probs - 1) : 0.0;
+
+    int i_prob; // Declare loop variables before the loop
+    for (i_prob = 0; i_prob < n_probs; i_prob++)
+    {
+        prob_spread[i_prob] = prob_min + (double)i_prob * prob_step;
+    }
+
+    // Results go out as partial reductions while the sweep runs
+    results_sink sink;
+    results_open(&sink, n_probs, prob_spread, forest_size, n_trials, options->report_rounds,
+                 !options->block_schedule, options->csv_name, options->binary_name,
+                 options->progress_name, options->show_graph);
+    long local_trials = 0;
+    long first_batch = 0;
+    long first_round = 0;
+
+    // A checkpoint of this run takes precedence over a results snapshot
+    checkpoint_header header;
+    checkpoint_state state;
+    checkpoint_header_init(&header);
+    header.numProcesses = numProcesses;
+    header.n_probs = n_probs;
+    header.neighborhood = options->neighborhood;
+    header.bit_engine = options->bit_engine;
+    header.block_schedule = options->block_schedule;
+    header.forest_size = forest_size;
+    header.n_trials = n_trials;
+    header.start_i = options->start_i;
+    header.start_j = options->start_j;
+    header.prob_min = prob_min;
+    header.prob_max = prob_max;
+    if (options->checkpoint_name &&
+        checkpoint_restore(options->checkpoint_name, &header, &state, n_probs,
+                           local_percent_burned, local_iterations))
+    {
+        first_round = state.next_round;
+        first_batch = state.first_batch;
+        local_trials = state.local_trials;
+        if (bits)
+        {
+            bits->rng = state.rng;
+        }
+        else
+        {
+            scalar_rng = state.rng;
+        }
+        // so that the progress log's rate counts only this run's trials
+        MPI_Allreduce(&local_trials, &sink.first_trials, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+        if (id == 0)
+        {
+            printf("Restarting from %s at round %ld, trial %ld of %ld\n", options->checkpoint_name,
+                   first_round, sink.first_trials, n_trials);
+        }
+    }
+    else if (options->resume_name)
+    {
+        long first_trials = results_resume(&sink, options->resume_name, batch_trials,
+                                           local_percent_burned, local_iterations);
+        first_batch = (first_trials + batch_trials - 1) / batch_trials;
+        if (id == 0)
+        {
+            local_trials = first_trials;
+        }
+    }
 
-    // Parallel computation
-    int i_trial, i_prob; // Declare loop variables before the loop
-    for (i_trial = id; i_trial < n_trials; i_trial += numProcesses)
+    // Parallel computation: trials are dealt out in batches (of BIT_LANES
+    // trials for the bit engine, which runs a whole batch at once).
+    // Every process runs the same number of rounds, so that the partial
+    // reductions line up even when some have no batch left.
+    long n_batches = (n_trials + batch_trials - 1) / batch_trials;
+    long n_rounds = (n_batches - first_batch + numProcesses - 1) / numProcesses;
+    long i_round, i_batch;
+    for (i_round = first_round; i_round < n_rounds; i_round++)
     {
-        for (i_prob = 0; i_prob < n_probs; i_prob++)
+        i_batch = schedule_batch(options, id, numProcesses, first_batch, n_batches, i_round);
+        if (i_batch >= 0)
+        {
+            int n_lanes = n_trials - i_batch * batch_trials;
+            if (n_lanes > batch_trials)
+            {
+                n_lanes = batch_trials;
+            }
+            for (i_prob = 0; i_prob < n_probs; i_prob++)
+            {
+                if (bits)
+                {
+                    local_iterations[i_prob] += bit_burn_until_out(bits, prob_spread[i_prob], options->start_i, options->start_j, n_lanes);
+                    local_percent_burned[i_prob] += bit_get_percent_burned(bits, n_lanes);
+                }
+                else
+                {
+                    local_iterations[i_prob] += burn_until_out(forest_size, forest, prob_spread[i_prob], options->start_i, options->start_j, options->neighborhood);
+                    local_percent_burned[i_prob] += get_percent_burned(forest_size, forest);
+                }
+                results_progress(&sink); // the last partial reduction moves along meanwhile
+            }
+            local_trials += n_lanes;
+        }
+        results_round(&sink, i_round, local_percent_burned, local_iterations, local_trials);
+
+        if (options->checkpoint_name && (i_round + 1) % options->checkpoint_rounds == 0 &&
+            i_round + 1 < n_rounds)
         {
-            prob_spread[i_prob] = prob_min + (double)i_prob * prob_step;
-            local_iterations[i_prob] += burn_until_out(forest_size, forest, prob_spread[i_prob], forest_size / 2, forest_size / 2);
-            local_percent_burned[i_prob] += get_percent_burned(forest_size, forest);
+            state.next_round = i_round + 1;
+            state.first_batch = first_batch;
+            state.local_trials = local_trials;
+            state.rng = bits ? bits->rng : scalar_rng;
+            checkpoint_save(options->checkpoint_name, &header, &state, n_probs,
+                            local_percent_burned, local_iterations);
         }
     }
 
     // MPI reduction
-    MPI_Reduce(local_percent_burned, global_percent_burned, n_probs, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-    MPI_Reduce(local_iterations, global_iterations, n_probs, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    results_finish(&sink, local_percent_burned, local_iterations, local_trials,
+                   global_percent_burned, global_iterations);
 
     // Normalize and print results
     if (id == 0)
@@ -90,7 +445,7 @@ int main(int argc, char **argv)
         {
             global_percent_burned[i_prob] /= n_trials;
             global_iterations[i_prob] /= n_trials;
-            printf("%lf, %lf, %d\n", prob_spread[i_prob], global_percent_burned[i_prob], global_iterations[i_prob]);
+            printf("%lf, %lf, %ld\n", prob_spread[i_prob], global_percent_burned[i_prob], global_iterations[i_prob]);
         }
 
         // End timing and print execution time
@@ -99,27 +454,82 @@ int main(int argc, char **argv)
     }
 
     // Cleanup
-    delete_forest(forest_size, forest);
+    results_close(&sink);
+    if (bits)
+    {
+        delete_bit_forest(bits);
+    }
+    else
+    {
+        delete_forest(forest_size, forest);
+    }
     free(prob_spread);
     free(local_percent_burned);
     free(global_percent_burned);
     free(local_iterations);
     free(global_iterations);
+}
 
-    // Finalize MPI
-    MPI_Finalize();
-    return 0;
+/* burn a single forest_size x forest_size forest, decomposed into
+ *  one block per process, and report how much of it burned
+ */
+static void burn_one_large_forest(int id, int numProcesses, fire_options *options)
+{
+    double start_time = MPI_Wtime();
+    long forest_size = options->forest_size;
+    double prob_spread = options->prob_min;
+
+    if (options->neighborhood != 4)
+    {
+        if (id == 0)
+        {
+            fprintf(stderr, "*** domain mode only spreads fire to the 4 nearest trees (-N 4)\n");
+        }
+        return;
+    }
+    if (forest_size < numProcesses)
+    {
+        if (id == 0)
+        {
+            fprintf(stderr, "*** forestSize (%ld) must be at least the number of processes (%d)\n",
+                    forest_size, numProcesses);
+        }
+        return;
+    }
+
+    domain_forest *forest = allocate_domain_forest(forest_size, MPI_COMM_WORLD);
+    if (forest == NULL)
+    {
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    // every block seeds its own stream from the run's seed, as the trial sweep does
+    uint64_t seed = options->seed_given ? options->seed : (uint64_t)time(NULL);
+    MPI_Bcast(&seed, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+    seed_domain_forest(forest, seed);
+
+    long iterations = domain_burn_until_out(forest, prob_spread, options->start_i, options->start_j);
+    double percent_burned = domain_get_percent_burned(forest);
+
+    if (id == 0)
+    {
+        printf("Forest %ld x %ld on a %d x %d process grid\n", forest_size, forest_size, forest->dims[0], forest->dims[1]);
+        printf("Probability, Percent Burned, Iterations\n");
+        printf("%lf, %lf, %ld\n", prob_spread, percent_burned, iterations);
+        printf("Execution Time: %f seconds\n", MPI_Wtime() - start_time);
+    }
+
+    delete_domain_forest(forest);
 }
-#include <time.h>
 
-void seed_by_time(int offset)
+// the scalar engine's random stream (a checkpoint saves and restores it)
+uint64_t scalar_rng = 0x9E3779B97F4A7C15ULL;
+
+void seed_scalar_forest(uint64_t seed)
 {
-    time_t the_time;
-    time(&the_time);
-    srand((int)the_time + offset);
+    scalar_rng = forest_random_seed(seed);
 }
 
-int burn_until_out(int forest_size, int **forest, double prob_spread, int start_i, int start_j)
+int burn_until_out(int forest_size, int **forest, double prob_spread, int start_i, int start_j, int neighborhood)
 {
     int count = 0;
     initialize_forest(forest_size, forest);
@@ -127,7 +537,7 @@ int burn_until_out(int forest_size, int **forest, double prob_spread, int start_
 
     while (forest_is_burning(forest_size, forest))
     {
-        forest_burns(forest_size, forest, prob_spread);
+        forest_burns(forest_size, forest, prob_spread, neighborhood);
         count++;
     }
     return count; // Return the iteration count
@@ -200,12 +610,15 @@ void light_tree(int forest_size, int **forest, int i, int j)
 
 boolean fire_spreads(double prob_spread)
 {
-    return (double)rand() / (double)RAND_MAX < prob_spread;
+    // 53 random bits as a fraction in [0,1)
+    return (double)(forest_random(&scalar_rng) >> 11) * (1.0 / 9007199254740992.0) < prob_spread;
 }
 
-void forest_burns(int forest_size, int **forest, double prob_spread)
+/* one step of the fire; with neighborhood 8 it also spreads diagonally
+ */
+void forest_burns(int forest_size, int **forest, double prob_spread, int neighborhood)
 {
-    int i, j;
+    int i, j, di, dj;
     extern boolean fire_spreads(double);
 
     // burning trees burn down, smoldering trees ignite
@@ -255,6 +668,20 @@ void forest_burns(int forest_size, int **forest, double prob_spread)
                         forest[i][j + 1] = SMOLDERING;
                     }
                 }
+                if (neighborhood == 8)
+                { // Diagonals
+                    for (di = -1; di <= 1; di += 2)
+                    {
+                        for (dj = -1; dj <= 1; dj += 2)
+                        {
+                            if (i + di >= 0 && i + di < forest_size && j + dj >= 0 && j + dj < forest_size &&
+                                fire_spreads(prob_spread) && forest[i + di][j + dj] == UNBURNT)
+                            {
+                                forest[i + di][j + dj] = SMOLDERING;
+                            }
+                        }
+                    }
+                }
             }
         }
     }
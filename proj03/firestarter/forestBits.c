@@ -0,0 +1,275 @@
+/* forestBits.c defines the bit-sliced forest engine declared in forestBits.h.
+ *
+ * One call to bit_burn_until_out() runs n_lanes independent trials of
+ *  the same experiment burn_until_out() runs once: light the tree at
+ *  (start_i, start_j) and let the fire spread with probability
+ *  prob_spread until every lane has burned out.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "forestBits.h"
+#include "forestRandom.h"
+
+/* return a mask in which each lane of want is set with probability
+ *  threshold / 2^32, independently of every other lane.
+ *
+ * Each lane compares a uniform random fraction against threshold one
+ *  bit at a time, most significant bit first; a lane is decided at the
+ *  first bit where the two differ, so the loop usually stops after
+ *  a few words instead of drawing 32 random bits per lane.
+ */
+static inline lanes spread_mask(bit_forest *forest, lanes want, uint32_t threshold)
+{
+    lanes result = 0;
+    lanes undecided = want;
+    int bit;
+
+    for (bit = 31; bit >= 0 && undecided; bit--)
+    {
+        lanes r = forest_random(&forest->rng);
+        if ((threshold >> bit) & 1)
+        {
+            result |= undecided & ~r; // random bit 0 < threshold bit 1
+            undecided &= r;
+        }
+        else
+        {
+            undecided &= ~r; // random bit 1 > threshold bit 0
+        }
+    }
+    return result;
+}
+
+static lanes lane_mask(int n_lanes)
+{
+    return n_lanes >= BIT_LANES ? ~(lanes)0 : (((lanes)1 << n_lanes) - 1);
+}
+
+/* the body of bit_burn_until_out(), written once for any forest size
+ *  and neighborhood; see the kernel table below for how it is used.
+ */
+static inline __attribute__((always_inline)) long burn_kernel(bit_forest *forest, double prob_spread,
+                                                             int start_i, int start_j, int n_lanes,
+                                                             const int size, const int moore)
+{
+    const lanes valid = lane_mask(n_lanes);
+    lanes *smoldering = forest->smoldering;
+    lanes *burning = forest->burning;
+    lanes *burnt = forest->burnt;
+    const uint32_t threshold = forest_random_threshold(prob_spread);
+    const int always = prob_spread >= 1.0;
+    long count = 0;
+    int i, j, k;
+
+    // initialize_forest() + light_tree() for every lane
+    for (i = 0; i < size * size; i++)
+    {
+        smoldering[i] = burning[i] = burnt[i] = 0;
+    }
+    smoldering[start_i * size + start_j] = valid;
+
+    // the fire can only be inside [top,bottom] x [left,right]
+    int top = start_i, bottom = start_i, left = start_j, right = start_j;
+    lanes active = valid;
+
+    while (active)
+    {
+        count += __builtin_popcountll(active);
+
+        // burning trees burn down, smoldering trees ignite
+        for (i = top; i <= bottom; i++)
+        {
+            for (j = left; j <= right; j++)
+            {
+                int c = i * size + j;
+                burnt[c] |= burning[c];
+                burning[c] = smoldering[c];
+                smoldering[c] = 0;
+            }
+        }
+
+        // unburnt trees next to burning ones catch fire
+        int r0 = top > 0 ? top - 1 : 0;
+        int r1 = bottom < size - 1 ? bottom + 1 : size - 1;
+        int c0 = left > 0 ? left - 1 : 0;
+        int c1 = right < size - 1 ? right + 1 : size - 1;
+        top = size, bottom = -1, left = size, right = -1;
+        active = 0;
+
+        for (i = r0; i <= r1; i++)
+        {
+            for (j = c0; j <= c1; j++)
+            {
+                int c = i * size + j;
+                int n = i != 0, s = i != size - 1, w = j != 0, e = j != size - 1;
+                lanes unburnt = valid & ~(burning[c] | burnt[c]);
+                lanes from[8] = {
+                    n ? burning[c - size] & unburnt : 0,
+                    s ? burning[c + size] & unburnt : 0,
+                    w ? burning[c - 1] & unburnt : 0,
+                    e ? burning[c + 1] & unburnt : 0,
+                    moore && n && w ? burning[c - size - 1] & unburnt : 0,
+                    moore && n && e ? burning[c - size + 1] & unburnt : 0,
+                    moore && s && w ? burning[c + size - 1] & unburnt : 0,
+                    moore && s && e ? burning[c + size + 1] & unburnt : 0};
+                lanes any = 0, caught = 0;
+
+                for (k = 0; k < (moore ? 8 : 4); k++)
+                {
+                    any |= from[k];
+                }
+                if (any)
+                {
+                    if (always)
+                    {
+                        caught = any;
+                    }
+                    else
+                    {
+                        // one independent draw per burning neighbor, as in forest_burns()
+                        for (k = 0; k < (moore ? 8 : 4); k++)
+                        {
+                            if (from[k])
+                                caught |= spread_mask(forest, from[k], threshold);
+                        }
+                    }
+                    smoldering[c] = caught;
+                }
+
+                if (caught | burning[c])
+                {
+                    active |= caught | burning[c];
+                    if (i < top)
+                        top = i;
+                    if (i > bottom)
+                        bottom = i;
+                    if (j < left)
+                        left = j;
+                    if (j > right)
+                        right = j;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+typedef long (*burn_function)(bit_forest *, double, int, int, int);
+
+/* Kernels specialized at compile time for the forest sizes we sweep most,
+ *  so the compiler can fold the row stride and neighborhood into the code.
+ *  Any other size falls back to the generic kernel; to add a size,
+ *  add a SPECIALIZED_KERNEL line and a row to kernel_table.
+ */
+#define SPECIALIZED_KERNEL(N)                                                         \
+    static long burn_##N##_von_neumann(bit_forest *f, double p, int i, int j, int n) \
+    {                                                                                 \
+        return burn_kernel(f, p, i, j, n, N, 0);                                      \
+    }                                                                                 \
+    static long burn_##N##_moore(bit_forest *f, double p, int i, int j, int n)       \
+    {                                                                                 \
+        return burn_kernel(f, p, i, j, n, N, 1);                                      \
+    }
+
+SPECIALIZED_KERNEL(20)
+SPECIALIZED_KERNEL(40)
+SPECIALIZED_KERNEL(80)
+SPECIALIZED_KERNEL(100)
+
+static const struct
+{
+    int size;
+    burn_function von_neumann, moore;
+} kernel_table[] = {
+    {20, burn_20_von_neumann, burn_20_moore},
+    {40, burn_40_von_neumann, burn_40_moore},
+    {80, burn_80_von_neumann, burn_80_moore},
+    {100, burn_100_von_neumann, burn_100_moore},
+};
+
+static long burn_generic_von_neumann(bit_forest *f, double p, int i, int j, int n)
+{
+    return burn_kernel(f, p, i, j, n, f->size, 0);
+}
+
+static long burn_generic_moore(bit_forest *f, double p, int i, int j, int n)
+{
+    return burn_kernel(f, p, i, j, n, f->size, 1);
+}
+
+/* allocate a forest_size x forest_size forest whose fires spread to the
+ *  4 (von Neumann) or 8 (Moore) nearest trees, as neighborhood says
+ */
+bit_forest *allocate_bit_forest(int forest_size, int neighborhood)
+{
+    unsigned k;
+    size_t n_cells = (size_t)forest_size * forest_size;
+    bit_forest *forest = (bit_forest *)malloc(sizeof(bit_forest));
+    if (forest == NULL)
+    {
+        return NULL;
+    }
+
+    forest->size = forest_size;
+    forest->burn = neighborhood == 8 ? burn_generic_moore : burn_generic_von_neumann;
+    for (k = 0; k < sizeof(kernel_table) / sizeof(kernel_table[0]); k++)
+    {
+        if (kernel_table[k].size == forest_size)
+        {
+            forest->burn = neighborhood == 8 ? kernel_table[k].moore : kernel_table[k].von_neumann;
+        }
+    }
+    forest->smoldering = (lanes *)calloc(n_cells, sizeof(lanes));
+    forest->burning = (lanes *)calloc(n_cells, sizeof(lanes));
+    forest->burnt = (lanes *)calloc(n_cells, sizeof(lanes));
+    forest->rng = 0x9E3779B97F4A7C15ULL;
+    if (!forest->smoldering || !forest->burning || !forest->burnt)
+    {
+        delete_bit_forest(forest);
+        return NULL;
+    }
+    return forest;
+}
+
+void delete_bit_forest(bit_forest *forest)
+{
+    free(forest->smoldering);
+    free(forest->burning);
+    free(forest->burnt);
+    free(forest);
+}
+
+void seed_bit_forest(bit_forest *forest, uint64_t seed)
+{
+    forest->rng = forest_random_seed(seed);
+}
+
+/* run n_lanes trials to completion
+ * Postcondition: forest holds the final state of every lane.
+ * @return: the sum over all lanes of the number of steps each lane burned,
+ *           i.e. the sum of what burn_until_out() would return per trial.
+ */
+long bit_burn_until_out(bit_forest *forest, double prob_spread,
+                        int start_i, int start_j, int n_lanes)
+{
+    return forest->burn(forest, prob_spread, start_i, start_j, n_lanes);
+}
+
+/* @return: the sum over the first n_lanes lanes of what
+ *           get_percent_burned() would return for each trial.
+ */
+double bit_get_percent_burned(bit_forest *forest, int n_lanes)
+{
+    const lanes valid = lane_mask(n_lanes);
+    int n_cells = forest->size * forest->size;
+    long sum = 0;
+    int i;
+
+    for (i = 0; i < n_cells; i++)
+    {
+        sum += __builtin_popcountll(forest->burnt[i] & valid);
+    }
+
+    // each lane discounts its ignition tree, as get_percent_burned() does
+    return (double)(sum - n_lanes) / (double)(n_cells - 1);
+}
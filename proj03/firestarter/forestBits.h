@@ -0,0 +1,39 @@
+/* forestBits.h declares a bit-sliced forest engine that runs up to
+ *  64 independent firestarter trials at once.
+ *
+ * Bit k of every word belongs to trial k, so one cell of the forest
+ *  is three uint64_t words (smoldering, burning, burnt) and a cell is
+ *  unburnt in every lane where none of those bits are set.
+ *  Spreading fire is then a handful of AND/OR operations per cell
+ *  across all trials, and the random spread decisions are drawn
+ *  64 lanes at a time.
+ *
+ * See: forestBits.c (definitions), firestarter.c (driver).
+ */
+#ifndef FOREST_BITS
+#define FOREST_BITS
+
+#include <stdint.h>
+
+#define BIT_LANES 64
+
+typedef uint64_t lanes;
+
+typedef struct bit_forest_mem {
+    int size;               // forest is size x size cells
+    long (*burn)(struct bit_forest_mem *, double, int, int, int); // kernel for size
+    lanes *smoldering;      // size*size words, row-major
+    lanes *burning;
+    lanes *burnt;
+    uint64_t rng;           // xorshift64* state
+} bit_forest;
+
+bit_forest *allocate_bit_forest(int forest_size, int neighborhood);
+void delete_bit_forest(bit_forest *forest);
+void seed_bit_forest(bit_forest *forest, uint64_t seed);
+
+long bit_burn_until_out(bit_forest *forest, double prob_spread,
+                        int start_i, int start_j, int n_lanes);
+double bit_get_percent_burned(bit_forest *forest, int n_lanes);
+
+#endif
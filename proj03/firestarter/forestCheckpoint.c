@@ -0,0 +1,124 @@
+/* forestCheckpoint.c defines the checkpoints declared in forestCheckpoint.h.
+ *
+ * File layout: checkpoint_header, then for each process in rank order
+ *  checkpoint_state, local_percent_burned[n_probs], local_iterations[n_probs].
+ */
+#include <stdio.h>
+#include <string.h>
+#include "forestCheckpoint.h"
+
+#define CHECKPOINT_MAGIC 0x4B434946 // "FICK"
+
+static MPI_Offset record_size(int n_probs)
+{
+    return sizeof(checkpoint_state) + n_probs * (sizeof(double) + sizeof(long));
+}
+
+/* zero a header (padding included, so headers compare with memcmp)
+ *  and stamp it; the caller fills in the configuration.
+ */
+void checkpoint_header_init(checkpoint_header *header)
+{
+    memset(header, 0, sizeof(checkpoint_header));
+    header->magic = CHECKPOINT_MAGIC;
+}
+
+/* write every process's state to name
+ * Precondition: every process calls this at the same round boundary,
+ *                with the same name and header.
+ * Postcondition: name holds this checkpoint, or (if writing failed)
+ *                 still holds the previous one.
+ */
+void checkpoint_save(const char *name, const checkpoint_header *header,
+                     const checkpoint_state *state, int n_probs,
+                     const double *local_percent_burned, const long *local_iterations)
+{
+    char tmp_name[1024];
+    int id, numProcesses, error;
+    MPI_File file;
+    MPI_Offset offset;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
+    snprintf(tmp_name, sizeof(tmp_name), "%s.tmp", name);
+
+    error = MPI_File_open(MPI_COMM_WORLD, tmp_name, MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                          MPI_INFO_NULL, &file);
+    if (error != MPI_SUCCESS)
+    {
+        if (id == 0)
+        {
+            fprintf(stderr, "*** cannot write checkpoint %s\n", tmp_name);
+        }
+        return;
+    }
+    MPI_File_set_size(file, sizeof(checkpoint_header) + numProcesses * record_size(n_probs));
+
+    if (id == 0)
+    {
+        MPI_File_write_at(file, 0, header, sizeof(checkpoint_header), MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+    offset = sizeof(checkpoint_header) + id * record_size(n_probs);
+    MPI_File_write_at_all(file, offset, state, sizeof(checkpoint_state), MPI_BYTE, MPI_STATUS_IGNORE);
+    offset += sizeof(checkpoint_state);
+    MPI_File_write_at_all(file, offset, local_percent_burned, n_probs, MPI_DOUBLE, MPI_STATUS_IGNORE);
+    offset += n_probs * sizeof(double);
+    MPI_File_write_at_all(file, offset, local_iterations, n_probs, MPI_LONG, MPI_STATUS_IGNORE);
+
+    // closing is collective: once it returns, every record is in the file
+    MPI_File_close(&file);
+    if (id == 0)
+    {
+        rename(tmp_name, name);
+    }
+}
+
+/* read this process's state back from name
+ * Precondition: every process calls this, with the same name and header.
+ * Postcondition: if name holds a checkpoint written with this header,
+ *                 state and the accumulators are what checkpoint_save()
+ *                 was given on this process.
+ * @return: true iff the checkpoint was restored (the same on every process).
+ */
+int checkpoint_restore(const char *name, const checkpoint_header *header,
+                       checkpoint_state *state, int n_probs,
+                       double *local_percent_burned, long *local_iterations)
+{
+    int id, matches = 0;
+    checkpoint_header saved;
+    MPI_File file;
+    MPI_Offset offset;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    if (MPI_File_open(MPI_COMM_WORLD, name, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS)
+    {
+        return 0; // no checkpoint yet: a fresh start
+    }
+
+    if (id == 0)
+    {
+        MPI_Offset size = 0;
+        MPI_File_get_size(file, &size);
+        memset(&saved, 0, sizeof(saved));
+        MPI_File_read_at(file, 0, &saved, sizeof(checkpoint_header), MPI_BYTE, MPI_STATUS_IGNORE);
+        matches = memcmp(&saved, header, sizeof(checkpoint_header)) == 0 &&
+                  size == sizeof(checkpoint_header) + header->numProcesses * record_size(n_probs);
+        if (!matches)
+        {
+            fprintf(stderr, "*** %s is a checkpoint of a different run; starting over\n", name);
+        }
+    }
+    MPI_Bcast(&matches, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    if (matches)
+    {
+        offset = sizeof(checkpoint_header) + id * record_size(n_probs);
+        MPI_File_read_at_all(file, offset, state, sizeof(checkpoint_state), MPI_BYTE, MPI_STATUS_IGNORE);
+        offset += sizeof(checkpoint_state);
+        MPI_File_read_at_all(file, offset, local_percent_burned, n_probs, MPI_DOUBLE, MPI_STATUS_IGNORE);
+        offset += n_probs * sizeof(double);
+        MPI_File_read_at_all(file, offset, local_iterations, n_probs, MPI_LONG, MPI_STATUS_IGNORE);
+    }
+    MPI_File_close(&file);
+    return matches;
+}
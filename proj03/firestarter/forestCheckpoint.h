@@ -0,0 +1,53 @@
+/* forestCheckpoint.h declares coordinated checkpoints of a firestarter sweep.
+ *
+ * At a round boundary every process writes its accumulators, its trial
+ *  count and its random number generator state into one shared file with
+ *  MPI-IO: a header (written by process 0) followed by one fixed-size
+ *  record per process at offset header + id * record size.
+ * The file is written under a temporary name and renamed into place, so
+ *  a job killed mid-checkpoint still leaves the previous one behind.
+ *
+ * Restarting from a checkpoint with the same configuration and the same
+ *  number of processes continues every random stream exactly where it
+ *  stopped, so the sweep ends with the same bits it would have had
+ *  without the interruption.
+ *
+ * See: forestCheckpoint.c (definitions), firestarter.c (driver).
+ */
+#ifndef FOREST_CHECKPOINT
+#define FOREST_CHECKPOINT
+
+#include <stdint.h>
+#include <mpi.h>
+
+// everything that has to match for a checkpoint to be restartable
+typedef struct checkpoint_header_mem {
+    int magic;
+    int numProcesses;
+    int n_probs;
+    int neighborhood;
+    int bit_engine;
+    int block_schedule;
+    long forest_size;
+    long n_trials;
+    long start_i, start_j;
+    double prob_min, prob_max;
+} checkpoint_header;
+
+// one process's state at a round boundary
+typedef struct checkpoint_state_mem {
+    long next_round;            // first round not yet done
+    long first_batch;           // where the sweep started (see -R)
+    long local_trials;
+    uint64_t rng;
+} checkpoint_state;
+
+void checkpoint_header_init(checkpoint_header *header);
+void checkpoint_save(const char *name, const checkpoint_header *header,
+                     const checkpoint_state *state, int n_probs,
+                     const double *local_percent_burned, const long *local_iterations);
+int checkpoint_restore(const char *name, const checkpoint_header *header,
+                       checkpoint_state *state, int n_probs,
+                       double *local_percent_burned, long *local_iterations);
+
+#endif
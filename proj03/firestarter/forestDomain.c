@@ -0,0 +1,257 @@
+/* forestDomain.c defines the domain-decomposed forest declared in forestDomain.h.
+ *
+ * A step of domain_burn_until_out() does what forest_burns() does,
+ *  block by block:
+ *  1. burning trees burn down and smoldering trees ignite;
+ *  2. the block's edge rows/columns are sent to its neighbors with
+ *      forest->halo's persistent requests, and while they are in flight
+ *      the interior cells (which need no halo) catch fire from burning
+ *      neighbors;
+ *  3. once the halos arrive, the edge cells are updated too.
+ * An MPI_Allreduce of "anything still burning?" ends the loop everywhere
+ *  at the same step.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "forestDomain.h"
+#include "forestRandom.h"
+
+// same cell encoding as firestarter.c
+#define UNBURNT 0
+#define SMOLDERING 1
+#define BURNING 2
+#define BURNT 3
+
+// cell (i,j) of the block, with the halo at i,j = -1 and rows/cols
+#define CELL(f, i, j) ((f)->cells[(size_t)((i) + 1) * ((f)->cols + 2) + ((j) + 1)])
+
+/* split n cells among parts, giving the first n % parts one extra cell
+ * Postcondition: *first = first cell of part index && *count = its cell count.
+ */
+static void block_range(long n, int parts, int index, long *first, long *count)
+{
+    long chunk = n / parts;
+    long remainder = n % parts;
+
+    if (index < remainder)
+    {
+        *count = chunk + 1;
+        *first = index * (chunk + 1);
+    }
+    else
+    {
+        *count = chunk;
+        *first = index * chunk + remainder;
+    }
+}
+
+domain_forest *allocate_domain_forest(long forest_size, MPI_Comm comm)
+{
+    int numProcesses, periods[2] = {0, 0};
+    long first, count;
+    domain_forest *forest = (domain_forest *)calloc(1, sizeof(domain_forest));
+    if (forest == NULL)
+    {
+        return NULL;
+    }
+
+    MPI_Comm_size(comm, &numProcesses);
+    MPI_Dims_create(numProcesses, 2, forest->dims);
+    MPI_Cart_create(comm, 2, forest->dims, periods, 1, &forest->comm);
+    MPI_Comm_rank(forest->comm, &forest->id);
+    MPI_Cart_coords(forest->comm, forest->id, 2, forest->coords);
+
+    forest->size = forest_size;
+    block_range(forest_size, forest->dims[0], forest->coords[0], &first, &count);
+    forest->first_row = first;
+    forest->rows = (int)count;
+    block_range(forest_size, forest->dims[1], forest->coords[1], &first, &count);
+    forest->first_col = first;
+    forest->cols = (int)count;
+
+    forest->cells = (unsigned char *)calloc((size_t)(forest->rows + 2) * (forest->cols + 2), 1);
+    if (forest->cells == NULL)
+    {
+        MPI_Comm_free(&forest->comm);
+        free(forest);
+        return NULL;
+    }
+
+    MPI_Type_vector(forest->rows, 1, forest->cols + 2, MPI_UNSIGNED_CHAR, &forest->column);
+    MPI_Type_commit(&forest->column);
+
+    // north/south rows, then west/east columns; MPI_PROC_NULL at the edges
+    initNeighborExchange(&forest->halo, forest->comm, NEIGHBOR_PERSISTENT);
+    addCartShift(&forest->halo, 0, &CELL(forest, 0, 0), &CELL(forest, -1, 0),
+                 &CELL(forest, forest->rows - 1, 0), &CELL(forest, forest->rows, 0),
+                 forest->cols, MPI_UNSIGNED_CHAR);
+    addCartShift(&forest->halo, 1, &CELL(forest, 0, 0), &CELL(forest, 0, -1),
+                 &CELL(forest, 0, forest->cols - 1), &CELL(forest, 0, forest->cols),
+                 1, forest->column);
+    forest->rng = forest_random_seed(0);
+    return forest;
+}
+
+void delete_domain_forest(domain_forest *forest)
+{
+    freeNeighborExchange(&forest->halo);
+    MPI_Type_free(&forest->column);
+    MPI_Comm_free(&forest->comm);
+    free(forest->cells);
+    free(forest);
+}
+
+void seed_domain_forest(domain_forest *forest, uint64_t seed)
+{
+    forest->rng = forest_random_seed(seed ^ ((uint64_t)forest->id << 32));
+}
+
+/* let cell (i,j) catch fire from each burning neighbor with probability
+ *  prob_spread; halo cells outside the global forest are never burning.
+ * @return: true iff (i,j) is smoldering or burning afterwards.
+ */
+static inline int catch_fire(domain_forest *forest, int i, int j, uint32_t threshold, int always)
+{
+    unsigned char *cell = &CELL(forest, i, j);
+
+    if (*cell != UNBURNT)
+    {
+        return *cell == BURNING;
+    }
+
+    int burning_neighbors = (CELL(forest, i - 1, j) == BURNING) + (CELL(forest, i + 1, j) == BURNING) +
+                            (CELL(forest, i, j - 1) == BURNING) + (CELL(forest, i, j + 1) == BURNING);
+    int k;
+    for (k = 0; k < burning_neighbors; k++)
+    {
+        if (always || (uint32_t)(forest_random(&forest->rng) >> 32) < threshold)
+        {
+            *cell = SMOLDERING;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* a rectangle of block cells; empty when top > bottom
+ */
+typedef struct
+{
+    int top, bottom, left, right;
+} fire_box;
+
+static inline void grow_box(fire_box *box, int i, int j)
+{
+    if (i < box->top)
+        box->top = i;
+    if (i > box->bottom)
+        box->bottom = i;
+    if (j < box->left)
+        box->left = j;
+    if (j > box->right)
+        box->right = j;
+}
+
+/* light the tree at global (start_i, start_j) and burn until the fire is
+ *  out in every block.
+ * Only the part of the block the fire has reached (plus a one-cell border)
+ *  is swept each step, so a block pays nothing until the fire gets there.
+ * @return: the number of steps, as burn_until_out() counts them.
+ */
+long domain_burn_until_out(domain_forest *forest, double prob_spread,
+                           long start_i, long start_j)
+{
+    const int rows = forest->rows, cols = forest->cols;
+    const uint32_t threshold = forest_random_threshold(prob_spread);
+    const int always = prob_spread >= 1.0;
+    const fire_box empty = {rows, -1, cols, -1};
+    fire_box fire = empty;
+    long count = 0;
+    int burning = 0, anywhere_burning = 0;
+    int i, j;
+
+    // initialize_forest() + light_tree(), halo included
+    for (i = -1; i <= rows; i++)
+    {
+        for (j = -1; j <= cols; j++)
+        {
+            CELL(forest, i, j) = UNBURNT;
+        }
+    }
+    if (start_i >= forest->first_row && start_i < forest->first_row + rows &&
+        start_j >= forest->first_col && start_j < forest->first_col + cols)
+    {
+        CELL(forest, start_i - forest->first_row, start_j - forest->first_col) = SMOLDERING;
+        grow_box(&fire, start_i - forest->first_row, start_j - forest->first_col);
+        burning = 1;
+    }
+    MPI_Allreduce(&burning, &anywhere_burning, 1, MPI_INT, MPI_LOR, forest->comm);
+
+    while (anywhere_burning)
+    {
+        // burning trees burn down, smoldering trees ignite
+        for (i = fire.top; i <= fire.bottom; i++)
+        {
+            for (j = fire.left; j <= fire.right; j++)
+            {
+                unsigned char *cell = &CELL(forest, i, j);
+                if (*cell == BURNING)
+                    *cell = BURNT;
+                else if (*cell == SMOLDERING)
+                    *cell = BURNING;
+            }
+        }
+
+        // unburnt trees catch fire: interior first, while the halos travel
+        startNeighborExchange(&forest->halo);
+        int r0 = fire.top - 1 > 1 ? fire.top - 1 : 1;
+        int r1 = fire.bottom + 1 < rows - 2 ? fire.bottom + 1 : rows - 2;
+        int c0 = fire.left - 1 > 1 ? fire.left - 1 : 1;
+        int c1 = fire.right + 1 < cols - 2 ? fire.right + 1 : cols - 2;
+        fire = empty;
+        for (i = r0; i <= r1; i++)
+        {
+            for (j = c0; j <= c1; j++)
+            {
+                if (catch_fire(forest, i, j, threshold, always))
+                    grow_box(&fire, i, j);
+            }
+        }
+
+        // then the block's edge cells, which need the halos
+        finishNeighborExchange(&forest->halo);
+        for (i = 0; i < rows; i++)
+        {
+            int step = (i == 0 || i == rows - 1 || cols < 2) ? 1 : cols - 1;
+            for (j = 0; j < cols; j += step)
+            {
+                if (catch_fire(forest, i, j, threshold, always))
+                    grow_box(&fire, i, j);
+            }
+        }
+
+        count++;
+        burning = fire.top <= fire.bottom;
+        MPI_Allreduce(&burning, &anywhere_burning, 1, MPI_INT, MPI_LOR, forest->comm);
+    }
+    return count;
+}
+
+/* @return: get_percent_burned() of the whole forest, on every process.
+ */
+double domain_get_percent_burned(domain_forest *forest)
+{
+    long local_burnt = 0, global_burnt = 0;
+    int i, j;
+
+    for (i = 0; i < forest->rows; i++)
+    {
+        for (j = 0; j < forest->cols; j++)
+        {
+            local_burnt += CELL(forest, i, j) == BURNT;
+        }
+    }
+    MPI_Allreduce(&local_burnt, &global_burnt, 1, MPI_LONG, MPI_SUM, forest->comm);
+
+    return (double)(global_burnt - 1) / (double)(forest->size * forest->size - 1);
+}
@@ -0,0 +1,41 @@
+/* forestDomain.h declares a domain-decomposed forest for simulating
+ *  one fire on a forest too large for a single process.
+ *
+ * The forest_size x forest_size grid is split into 2D blocks, one per
+ *  MPI process, laid out on a Cartesian communicator. Each block keeps
+ *  a one-cell halo that is refreshed from the four neighboring blocks
+ *  every step, so memory per process is about forest_size^2 / P cells.
+ *  The halo's messages are persistent requests (common/neighborExchange.h),
+ *  made once per forest rather than once per step.
+ *
+ * See: forestDomain.c (definitions), firestarter.c (driver).
+ */
+#ifndef FOREST_DOMAIN
+#define FOREST_DOMAIN
+
+#include <stdint.h>
+#include <mpi.h>
+#include "../../common/neighborExchange.h"
+
+typedef struct domain_forest_mem {
+    MPI_Comm comm;              // 2D Cartesian communicator
+    int id;                     // rank in comm
+    int dims[2], coords[2];     // process grid and this block's place in it
+    long size;                  // global forest is size x size cells
+    long first_row, first_col;  // global index of this block's (0,0) cell
+    int rows, cols;             // cells owned by this block
+    unsigned char *cells;       // (rows+2) x (cols+2), halo included
+    MPI_Datatype column;        // one halo column of cells
+    neighborExchange halo;      // edge rows/columns out, halo in, every step
+    uint64_t rng;               // this block's random stream
+} domain_forest;
+
+domain_forest *allocate_domain_forest(long forest_size, MPI_Comm comm);
+void delete_domain_forest(domain_forest *forest);
+void seed_domain_forest(domain_forest *forest, uint64_t seed);
+
+long domain_burn_until_out(domain_forest *forest, double prob_spread,
+                           long start_i, long start_j);
+double domain_get_percent_burned(domain_forest *forest);
+
+#endif
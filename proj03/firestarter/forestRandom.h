@@ -0,0 +1,50 @@
+/* forestRandom.h defines the small, seedable random number generator
+ *  shared by the forest engines.
+ *
+ * Unlike rand(), its whole state is one uint64_t that the engines own,
+ *  so every engine (and every MPI process) draws from its own stream.
+ */
+#ifndef FOREST_RANDOM
+#define FOREST_RANDOM
+
+#include <stdint.h>
+
+/* draw 64 random bits (xorshift64*), advancing *state
+ */
+static inline uint64_t forest_random(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/* turn a seed into a generator state
+ *  (a splitmix64 step, so that nearby seeds give unrelated streams
+ *   and the xorshift state is never 0)
+ */
+static inline uint64_t forest_random_seed(uint64_t seed)
+{
+    uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return z ? z : 0x9E3779B97F4A7C15ULL;
+}
+
+/* convert a spread probability into a threshold t for 32 random bits,
+ *  so that a spread happens when those bits < t
+ *  (probabilities >= 1 are handled by the callers as "always").
+ */
+static inline uint32_t forest_random_threshold(double prob_spread)
+{
+    if (prob_spread <= 0.0)
+        return 0;
+    if (prob_spread >= 1.0)
+        return UINT32_MAX;
+    return (uint32_t)(prob_spread * 4294967296.0);
+}
+
+#endif
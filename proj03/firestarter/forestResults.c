@@ -0,0 +1,309 @@
+/* forestResults.c defines the results pipeline declared in forestResults.h.
+ *
+ * Each partial reduction also sums the processes' trial counts, so the
+ *  sinks always know exactly how many trials a curve averages over.
+ * The reduction's fields are the driver's own accumulators, registered on
+ *  the first round; each start copies them, so the driver keeps adding to
+ *  them while the reduction is in flight.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "forestResults.h"
+
+#define SNAPSHOT_MAGIC 0x45524946 // "FIRE"
+
+/* rewrite name with the current averages in CSV form
+ */
+static void write_csv(results_sink *sink, long trials)
+{
+    char tmp_name[1024];
+    int i_prob;
+
+    snprintf(tmp_name, sizeof(tmp_name), "%s.tmp", sink->csv_name);
+    FILE *file = fopen(tmp_name, "w");
+    if (file == NULL)
+    {
+        perror(tmp_name);
+        return;
+    }
+    fprintf(file, "Probability,Average Percent Burned,Average Iterations\n");
+    for (i_prob = 0; i_prob < sink->n_probs; i_prob++)
+    {
+        fprintf(file, "%lf, %lf, %ld\n", sink->prob_spread[i_prob],
+                sink->sum_percent[i_prob] / trials, sink->sum_iterations[i_prob] / trials);
+    }
+    fclose(file);
+    rename(tmp_name, sink->csv_name);
+}
+
+/* rewrite name with the current sums, in the form results_resume() reads
+ */
+static void write_snapshot(results_sink *sink, long trials)
+{
+    char tmp_name[1024];
+    int header[3] = {SNAPSHOT_MAGIC, sink->n_probs, sink->resumable};
+    long sizes[3] = {sink->forest_size, sink->n_trials, trials};
+
+    snprintf(tmp_name, sizeof(tmp_name), "%s.tmp", sink->binary_name);
+    FILE *file = fopen(tmp_name, "wb");
+    if (file == NULL)
+    {
+        perror(tmp_name);
+        return;
+    }
+    fwrite(header, sizeof(int), 3, file);
+    fwrite(sizes, sizeof(long), 3, file);
+    fwrite(sink->prob_spread, sizeof(double), sink->n_probs, file);
+    fwrite(sink->sum_percent, sizeof(double), sink->n_probs, file);
+    fwrite(sink->sum_iterations, sizeof(long), sink->n_probs, file);
+    fclose(file);
+    rename(tmp_name, sink->binary_name);
+}
+
+/* hand the sums over trials trials to every sink (process 0 only)
+ */
+static void publish(results_sink *sink, long trials, int final)
+{
+    int i_prob;
+
+    if (trials == 0)
+    {
+        return;
+    }
+    if (sink->csv_name)
+    {
+        write_csv(sink, trials);
+    }
+    if (sink->binary_name)
+    {
+        write_snapshot(sink, trials);
+    }
+    if (sink->progress)
+    {
+        double elapsed = MPI_Wtime() - sink->start_time;
+        long new_trials = trials - sink->first_trials;
+        double rate = elapsed > 0 ? new_trials / elapsed : 0;
+        double eta = rate > 0 ? (sink->n_trials - trials) / rate : 0;
+        fprintf(sink->progress, "%s %ld/%ld trials, %.1f s elapsed, %.1f trials/s, ETA %.1f s\n",
+                final ? "done" : "partial", trials, sink->n_trials, elapsed, rate, eta);
+        fflush(sink->progress);
+    }
+    if (sink->show_graph)
+    {
+        for (i_prob = 0; i_prob < sink->n_probs; i_prob++)
+        {
+            sink->curve[i_prob] = sink->sum_percent[i_prob] / trials;
+        }
+        xgraphDraw(&sink->graph, sink->n_probs, 0, 0, 1, 1, (double *)sink->prob_spread, sink->curve);
+    }
+}
+
+/* open the sinks
+ * Precondition: every process calls this with the same arguments
+ *            && prob_spread holds n_probs values and outlives the sink.
+ *            && resumable is true iff the trials done at any round are
+ *                always the first ones of the sweep (a cyclic schedule),
+ *                which is what makes a snapshot resumable.
+ * Note: only process 0 opens files or the display; a NULL name means
+ *        that sink is not wanted, and every = 0 means no partial results.
+ */
+void results_open(results_sink *sink, int n_probs, const double *prob_spread,
+                  int forest_size, long n_trials, int every, int resumable,
+                  const char *csv_name, const char *binary_name,
+                  const char *progress_name, int show_graph)
+{
+    memset(sink, 0, sizeof(results_sink));
+    MPI_Comm_rank(MPI_COMM_WORLD, &sink->id);
+    MPI_Comm_size(MPI_COMM_WORLD, &sink->numProcesses);
+    sink->n_probs = n_probs;
+    sink->prob_spread = prob_spread;
+    sink->forest_size = forest_size;
+    sink->n_trials = n_trials;
+    sink->every = every;
+    sink->resumable = resumable;
+    sink->start_time = MPI_Wtime();
+    getTopology(MPI_COMM_WORLD); // the node communicators of the reductions, made now
+    initAsyncReduction(&sink->partial, 1);
+
+    sink->sum_percent = (double *)calloc(n_probs, sizeof(double));
+    sink->sum_iterations = (long *)calloc(n_probs, sizeof(long));
+    sink->curve = (double *)calloc(n_probs, sizeof(double));
+    if (!sink->sum_percent || !sink->sum_iterations || !sink->curve)
+    {
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    if (sink->id == 0)
+    {
+        sink->csv_name = csv_name;
+        sink->binary_name = binary_name;
+        if (progress_name)
+        {
+            sink->progress = fopen(progress_name, "a");
+            if (sink->progress == NULL)
+            {
+                perror(progress_name);
+            }
+        }
+        sink->show_graph = show_graph;
+        if (show_graph)
+        {
+            xgraphSetup(&sink->graph, 300, 300);
+        }
+    }
+}
+
+/* pick up a sweep where the snapshot in binary_name left off
+ * Precondition: every process calls this, before the first round.
+ * Postcondition: if binary_name holds a resumable snapshot of this same
+ *                 sweep whose trial count is a multiple of batch_trials,
+ *                 its sums have been added to process 0's accumulators.
+ * @return: the number of trials in the snapshot (0 without one); the
+ *           caller must skip exactly those trials.
+ */
+long results_resume(results_sink *sink, const char *binary_name, long batch_trials,
+                    double *local_percent_burned, long *local_iterations)
+{
+    long first_trials = 0;
+    int i_prob;
+
+    if (sink->id == 0)
+    {
+        FILE *file = fopen(binary_name, "rb");
+        if (file != NULL)
+        {
+            int header[3] = {0, 0, 0};
+            long sizes[3] = {0, 0, 0};
+            double *prob = (double *)calloc(sink->n_probs, sizeof(double));
+            size_t n = fread(header, sizeof(int), 3, file);
+            n += fread(sizes, sizeof(long), 3, file);
+
+            if (n == 6 && header[0] == SNAPSHOT_MAGIC && header[1] == sink->n_probs && header[2] &&
+                sizes[0] == sink->forest_size && sizes[1] == sink->n_trials &&
+                (sizes[2] % batch_trials == 0 || sizes[2] == sink->n_trials) &&
+                fread(prob, sizeof(double), sink->n_probs, file) == (size_t)sink->n_probs &&
+                fread(sink->sum_percent, sizeof(double), sink->n_probs, file) == (size_t)sink->n_probs &&
+                fread(sink->sum_iterations, sizeof(long), sink->n_probs, file) == (size_t)sink->n_probs)
+            {
+                for (i_prob = 0; i_prob < sink->n_probs; i_prob++)
+                {
+                    local_percent_burned[i_prob] += sink->sum_percent[i_prob];
+                    local_iterations[i_prob] += sink->sum_iterations[i_prob];
+                }
+                first_trials = sizes[2];
+                printf("Resuming from %s at trial %ld of %ld\n", binary_name,
+                       first_trials, sink->n_trials);
+            }
+            else
+            {
+                fprintf(stderr, "*** %s is not a resumable snapshot of this sweep; starting over\n", binary_name);
+            }
+            free(prob);
+            fclose(file);
+        }
+    }
+
+    MPI_Bcast(&first_trials, 1, MPI_LONG, 0, MPI_COMM_WORLD);
+    sink->first_trials = first_trials;
+    return first_trials;
+}
+
+/* register the driver's accumulators as the reduction's fields, once
+ */
+static void watch_accumulators(results_sink *sink, const double *local_percent_burned,
+                               const long *local_iterations)
+{
+    if (sink->partial.numFields == 0)
+    {
+        addReductionField(&sink->partial, local_percent_burned, sink->sum_percent, sink->n_probs,
+                          MPI_DOUBLE, MPI_SUM);
+        addReductionField(&sink->partial, local_iterations, sink->sum_iterations, sink->n_probs,
+                          MPI_LONG, MPI_SUM);
+        addReductionField(&sink->partial, &sink->send_trials, &sink->sum_trials, 1,
+                          MPI_LONG, MPI_SUM);
+    }
+}
+
+/* finish the pending partial reduction, if any, and publish it
+ */
+static void complete_pending(results_sink *sink)
+{
+    if (sink->pending)
+    {
+        finishAsyncReduction(&sink->partial);
+        sink->pending = 0;
+        if (sink->id == 0)
+        {
+            publish(sink, sink->sum_trials, 0);
+        }
+    }
+}
+
+/* may be called by any process as often as it likes during a round,
+ *  to move the partial reduction in flight along
+ * Postcondition: if it has finished, it has been published.
+ */
+void results_progress(results_sink *sink)
+{
+    if (sink->pending && progressAsyncReduction(&sink->partial))
+    {
+        complete_pending(sink);
+    }
+}
+
+/* called by every process after each round of the trial loop
+ * Postcondition: every sink->every rounds a partial reduction of the
+ *                 accumulators has been started, and a finished one
+ *                 has been published.
+ */
+void results_round(results_sink *sink, long round, const double *local_percent_burned,
+                   const long *local_iterations, long local_trials)
+{
+    results_progress(sink);
+
+    if (sink->every > 0 && (round + 1) % sink->every == 0)
+    {
+        // the same round on every process, so the collectives match up
+        complete_pending(sink);
+        watch_accumulators(sink, local_percent_burned, local_iterations);
+        sink->send_trials = local_trials;
+        startAsyncReduction(&sink->partial, 0, MPI_COMM_WORLD);
+        sink->pending = 1;
+    }
+}
+
+/* reduce the final sums and publish them
+ * Postcondition: on process 0, global_percent_burned and global_iterations
+ *                 hold the sums over every trial of the sweep.
+ */
+void results_finish(results_sink *sink, const double *local_percent_burned,
+                    const long *local_iterations, long local_trials,
+                    double *global_percent_burned, long *global_iterations)
+{
+    complete_pending(sink);
+    watch_accumulators(sink, local_percent_burned, local_iterations);
+    sink->send_trials = local_trials;
+    startAsyncReduction(&sink->partial, 0, MPI_COMM_WORLD);
+    finishAsyncReduction(&sink->partial);
+    // how much the computing hid goes to the progress log, if there is one
+    reportAsyncReduction(&sink->partial, "Result reductions", sink->progress);
+
+    if (sink->id == 0)
+    {
+        memcpy(global_percent_burned, sink->sum_percent, sink->n_probs * sizeof(double));
+        memcpy(global_iterations, sink->sum_iterations, sink->n_probs * sizeof(long));
+        publish(sink, sink->sum_trials, 1);
+    }
+}
+
+void results_close(results_sink *sink)
+{
+    if (sink->progress)
+    {
+        fclose(sink->progress);
+    }
+    freeAsyncReduction(&sink->partial);
+    free(sink->sum_percent);
+    free(sink->sum_iterations);
+    free(sink->curve);
+}
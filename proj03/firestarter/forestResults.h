@@ -0,0 +1,70 @@
+/* forestResults.h declares the results pipeline of a firestarter sweep.
+ *
+ * Every few rounds of the trial loop, the per-process accumulators are
+ *  summed onto process 0 with one nonblocking reduction (the percentages,
+ *  the iterations and the trial count fused into one derived datatype, by
+ *  common/asyncReduction.h) that finishes while the next round computes;
+ *  results_progress() moves it along from inside a round. Process 0 then
+ *  hands the partial curve to whichever sinks were requested:
+ *  - a CSV file of the current averages (the format output.csv has always had),
+ *  - a binary snapshot that a later run can resume from,
+ *  - a progress log of trials done, trials/sec and ETA,
+ *  - the X11 graph (xgraphDraw), if a display is wanted.
+ * Both the partial and the final sums are reduced within each node first,
+ *  so one process per node uses the network, and results_finish() writes
+ *  to the progress log how much of the reductions' time the computing hid.
+ * Files are rewritten through a temporary name and rename(), so a crash
+ *  leaves the last complete snapshot behind.
+ *
+ * See: forestResults.c (definitions), firestarter.c (driver).
+ */
+#ifndef FOREST_RESULTS
+#define FOREST_RESULTS
+
+#include <stdio.h>
+#include <mpi.h>
+#include "X-graph.h"
+#include "../../common/asyncReduction.h"
+
+typedef struct results_sink_mem {
+    int id;                     // MPI rank
+    int numProcesses;
+    int n_probs;
+    const double *prob_spread;  // the x-axis, owned by the driver
+    int forest_size;
+    long n_trials;              // trials in the whole sweep
+    long first_trials;          // trials that came from a snapshot
+    int every;                  // rounds between partial reductions
+    int resumable;              // trials are always done first-to-last
+    double start_time;
+
+    // one partial reduction in flight, the three accumulators fused into one
+    asyncReduction partial;
+    double *sum_percent;
+    long *sum_iterations;
+    long send_trials, sum_trials;
+    int pending;
+
+    const char *csv_name;       // sinks (NULL when not wanted)
+    const char *binary_name;
+    FILE *progress;
+    int show_graph;
+    xgraph graph;
+    double *curve;
+} results_sink;
+
+void results_open(results_sink *sink, int n_probs, const double *prob_spread,
+                  int forest_size, long n_trials, int every, int resumable,
+                  const char *csv_name, const char *binary_name,
+                  const char *progress_name, int show_graph);
+long results_resume(results_sink *sink, const char *binary_name, long batch_trials,
+                    double *local_percent_burned, long *local_iterations);
+void results_round(results_sink *sink, long round, const double *local_percent_burned,
+                   const long *local_iterations, long local_trials);
+void results_progress(results_sink *sink);
+void results_finish(results_sink *sink, const double *local_percent_burned,
+                    const long *local_iterations, long local_trials,
+                    double *global_percent_burned, long *global_iterations);
+void results_close(results_sink *sink);
+
+#endif
@@ -20,6 +20,7 @@
 #include <stdlib.h>    // Standard library functions, including exit
 #include <vector>      // Use of vector container
 #include "OO_MPI_IO.h" // MPI-based Input/Output operations
+#include "../common/collectives.h" // hierarchicalReduce()
 #include <mpi.h>       // MPI library
 
 typedef double Item; // Defining 'Item' as an alias for double
@@ -45,6 +46,7 @@ int main(int argc, char *argv[])
     MPI_Init(&argc, &argv);
     MPI_Comm_size(MPI_COMM_WORLD, &numProcs); // Get the total number of processes
     MPI_Comm_rank(MPI_COMM_WORLD, &id);       // Get the current process ID
+    const topology *where = getTopology(MPI_COMM_WORLD); // Node communicators, made once, untimed
 
     if (argc != 2)
     {
@@ -72,11 +74,12 @@ int main(int argc, char *argv[])
     double computationStartTime = MPI_Wtime();
 
     // Compute sum of squares for the chunk
-    double chunkSum = arraySquareAndSum(vec);
+    double chunk[2] = {arraySquareAndSum(vec), (double) vec.size()};
 
-    // Reduce operation to sum up the chunks from all processes
-    double totalSum = 0.0;
-    MPI_Reduce(&chunkSum, &totalSum, 1, MPI_DOUBLE, MPI_SUM, MASTER, MPI_COMM_WORLD);
+    // Reduce the chunks' sums and item counts (exact as doubles) from all processes
+    // in one reduction: within each node first, then one per node over the network
+    double total[2] = {0.0, 0.0};
+    hierarchicalReduce(chunk, total, 2, MPI_DOUBLE, MPI_SUM, MASTER, MPI_COMM_WORLD);
 
     // Stop timing for computation
     computationTime = MPI_Wtime() - computationStartTime;
@@ -87,10 +90,12 @@ int main(int argc, char *argv[])
     // MASTER process prints the result
     if (id == MASTER)
     {
-        printf("The sum of the squares of the values in the file '%s' is %g\n", argv[1], totalSum);
+        printf("The sum of the squares of the %.0f values in the file '%s' is %g\n",
+               total[1], argv[1], total[0]);
         printf("Time taken for file reading: %f seconds\n", fileReadTime);
         printf("Time taken for computation: %f seconds\n", computationTime);
         printf("Total time: %f secs\n", totalTime);
+        printf("Processes: %d on %d node(s)\n", numProcs, where->numNodes);
     }
 
     // Finalize the MPI environment